@@ -0,0 +1,2467 @@
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <compare>
+#include <stdexcept>
+#include <bit>
+#include <algorithm>
+#include <limits>
+#include <concepts>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <numbers>
+#include <functional>
+#include <array>
+#include <ranges>
+#include <charconv>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <optional>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+using NumberType = int64_t;
+using WideNumberType = __int128; // промежуточные результаты быстрого пути
+
+/// Количество младших нулевых битов, v != 0
+template<typename T>
+constexpr int trailingZeros(T v) {
+    if constexpr (sizeof(T) > sizeof(uint64_t)) {
+        if (static_cast<uint64_t>(v) == 0) return 64 + std::countr_zero(static_cast<uint64_t>(v >> 64));
+    }
+    return std::countr_zero(static_cast<uint64_t>(v));
+}
+
+/// Бинарный алгоритм Евклида (Стейна), результат неотрицателен
+template<typename T>
+constexpr T gcd(T a, T b) {
+    using Unsigned = std::conditional_t<(sizeof(T) > sizeof(uint64_t)), unsigned __int128, uint64_t>;
+    Unsigned u = a < 0 ? -static_cast<Unsigned>(a) : static_cast<Unsigned>(a);
+    Unsigned v = b < 0 ? -static_cast<Unsigned>(b) : static_cast<Unsigned>(b);
+
+    if (u == 0) return static_cast<T>(v);
+    if (v == 0) return static_cast<T>(u);
+
+    int shift = trailingZeros(u | v);
+    u >>= trailingZeros(u);
+    do {
+        v >>= trailingZeros(v);
+        if (u > v) std::swap(u, v);
+        v -= u;
+    } while (v != 0);
+
+    return static_cast<T>(u << shift);
+}
+
+
+template<typename T>
+constexpr T BinaryPower(T b, uint64_t e) {
+    T v = 1;
+    while (e != 0) {
+        if ((e & 1) != 0) {
+            v *= b;
+        }
+        e >>= 1;
+        if (e != 0) b *= b; // лишнее возведение в квадрат может переполниться
+    }
+    return v;
+}
+
+/// Целое произвольной длины: знак + модуль в виде 32-битных разрядов, младшие первыми
+class BigInteger {
+public:
+    using Limb = uint32_t;
+    using DoubleLimb = uint64_t;
+
+    constexpr BigInteger() = default;
+
+    constexpr BigInteger(NumberType value) : BigInteger(fromWide(value)) {}
+
+    static constexpr BigInteger powerOfTwo(size_t exponent) {
+        BigInteger result;
+        result._limbs.assign(exponent / 32 + 1, 0);
+        result._limbs.back() = Limb(1) << (exponent % 32);
+        return result;
+    }
+
+    static constexpr BigInteger fromWide(WideNumberType value) {
+        BigInteger result;
+        result._negative = value < 0;
+        auto magnitude = static_cast<unsigned __int128>(value);
+        if (result._negative) magnitude = -magnitude;
+
+        while (magnitude != 0) {
+            result._limbs.push_back(static_cast<Limb>(magnitude));
+            magnitude >>= 32;
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr bool isZero() const {
+        return _limbs.empty();
+    }
+
+    [[nodiscard]] constexpr bool isNegative() const {
+        return _negative;
+    }
+
+    [[nodiscard]] constexpr size_t bitLength() const {
+        if (_limbs.empty()) return 0;
+        return 32 * _limbs.size() - std::countl_zero(_limbs.back());
+    }
+
+    [[nodiscard]] constexpr bool fitsNumberType() const {
+        if (bitLength() < 64) return true;
+        // -2^63 тоже помещается
+        return _negative && bitLength() == 64 && _limbs[1] == 0x80000000u && _limbs[0] == 0;
+    }
+
+    /// Значение как NumberType, если fitsNumberType()
+    [[nodiscard]] constexpr NumberType toNumberType() const {
+        uint64_t magnitude = 0;
+        for (size_t i = std::min<size_t>(_limbs.size(), 2); i > 0; --i) {
+            magnitude = (magnitude << 32) | _limbs[i - 1];
+        }
+        return static_cast<NumberType>(_negative ? -magnitude : magnitude);
+    }
+
+    [[nodiscard]] constexpr double toDouble() const {
+        double result = 0.0;
+        for (size_t i = _limbs.size(); i > 0; --i) {
+            result = result * 4294967296.0 + _limbs[i - 1];
+        }
+        return _negative ? -result : result;
+    }
+
+    /// numerator / denominator в double без переполнения промежуточных значений
+    static double ratioToDouble(const BigInteger &numerator, const BigInteger &denominator) {
+        auto numerator_shift = static_cast<int>(std::max<size_t>(numerator.bitLength(), 64) - 64);
+        auto denominator_shift = static_cast<int>(std::max<size_t>(denominator.bitLength(), 64) - 64);
+        double top = static_cast<double>(numerator.topBits(numerator_shift));
+        double bottom = static_cast<double>(denominator.topBits(denominator_shift));
+        double result = std::ldexp(top / bottom, numerator_shift - denominator_shift);
+        return numerator._negative != denominator._negative ? -result : result;
+    }
+
+    constexpr BigInteger operator-() const {
+        BigInteger result = *this;
+        result._negative = !result._negative && !result.isZero();
+        return result;
+    }
+
+    friend constexpr BigInteger abs(BigInteger value) {
+        value._negative = false;
+        return value;
+    }
+
+    constexpr BigInteger operator+(const BigInteger &other) const {
+        if (_negative == other._negative) {
+            return make(addMagnitude(_limbs, other._limbs), _negative);
+        }
+        if (compareMagnitude(_limbs, other._limbs) >= 0) {
+            return make(subMagnitude(_limbs, other._limbs), _negative);
+        }
+        return make(subMagnitude(other._limbs, _limbs), other._negative);
+    }
+
+    constexpr BigInteger operator-(const BigInteger &other) const {
+        return *this + (-other);
+    }
+
+    constexpr BigInteger operator*(const BigInteger &other) const {
+        if (isZero() || other.isZero()) return {};
+        return make(multiplyMagnitude(_limbs, other._limbs), _negative != other._negative);
+    }
+
+    /// Деление с остатком с округлением к нулю, как у встроенных целых
+    static constexpr std::pair<BigInteger, BigInteger> divMod(const BigInteger &dividend, const BigInteger &divisor) {
+        if (divisor.isZero()) throw std::domain_error("BigInteger division by zero");
+
+        if (compareMagnitude(dividend._limbs, divisor._limbs) < 0) return {BigInteger(), dividend};
+
+        std::vector<Limb> quotient, remainder;
+        divModMagnitude(dividend._limbs, divisor._limbs, quotient, remainder);
+        return {
+                make(std::move(quotient), dividend._negative != divisor._negative),
+                make(std::move(remainder), dividend._negative)
+        };
+    }
+
+    constexpr BigInteger operator/(const BigInteger &other) const {
+        return divMod(*this, other).first;
+    }
+
+    constexpr BigInteger operator%(const BigInteger &other) const {
+        return divMod(*this, other).second;
+    }
+
+    constexpr BigInteger &operator+=(const BigInteger &other) {
+        return *this = *this + other;
+    }
+
+    constexpr BigInteger &operator-=(const BigInteger &other) {
+        return *this = *this - other;
+    }
+
+    constexpr BigInteger &operator*=(const BigInteger &other) {
+        return *this = *this * other;
+    }
+
+    constexpr BigInteger &operator/=(const BigInteger &other) {
+        return *this = *this / other;
+    }
+
+    constexpr bool operator==(const BigInteger &other) const = default;
+
+    constexpr std::strong_ordering operator<=>(const BigInteger &other) const {
+        if (_negative != other._negative) {
+            return _negative ? std::strong_ordering::less : std::strong_ordering::greater;
+        }
+        int cmp = compareMagnitude(_limbs, other._limbs);
+        if (_negative) cmp = -cmp;
+        return cmp <=> 0;
+    }
+
+    /// Алгоритм Лемера: шаги Евклида считаются по старшим 62 битам, а к длинным числам
+    /// применяется сразу их общая матрица, так что один проход по разрядам снимает ~30 бит
+    friend constexpr BigInteger gcd(BigInteger a, BigInteger b) {
+        a._negative = b._negative = false;
+        if (a < b) std::swap(a, b);
+
+        while (b.bitLength() > 64) {
+            int shift = static_cast<int>(a.bitLength()) - 62;
+            WideNumberType x = a.topBits(shift), y = b.topBits(shift);
+            WideNumberType A = 1, B = 0, C = 0, D = 1;
+            while (y + C != 0 && y + D != 0) {
+                WideNumberType q = (x + A) / (y + C);
+                if (q != (x + B) / (y + D)) break;
+                WideNumberType t = A - q * C;
+                A = C;
+                C = t;
+                t = B - q * D;
+                B = D;
+                D = t;
+                t = x - q * y;
+                x = y;
+                y = t;
+            }
+
+            if (B == 0) {
+                a = a % b;
+                std::swap(a, b);
+            } else {
+                BigInteger next_a = fromWide(A) * a + fromWide(B) * b;
+                b = fromWide(C) * a + fromWide(D) * b;
+                a = std::move(next_a);
+                if (a < b) std::swap(a, b);
+            }
+        }
+
+        while (!b.isZero()) {
+            a = a % b;
+            std::swap(a, b);
+        }
+        return a;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const BigInteger &value) {
+        if (value.isZero()) return out << 0;
+
+        // Разбиваем на куски по 9 десятичных цифр
+        std::vector<Limb> magnitude = value._limbs, chunks;
+        while (!magnitude.empty()) {
+            chunks.push_back(divSmall(magnitude, 1000000000u));
+        }
+
+        if (value._negative) out << '-';
+        out << chunks.back();
+        for (size_t i = chunks.size() - 1; i > 0; --i) {
+            std::string digits = std::to_string(chunks[i - 1]);
+            out << std::string(9 - digits.size(), '0') << digits;
+        }
+        return out;
+    }
+
+    /// Десятичная запись в [first, last) по соглашениям std::to_chars
+    friend std::to_chars_result toChars(char *first, char *last, const BigInteger &value) {
+        if (value.isZero()) return std::to_chars(first, last, 0);
+
+        std::vector<Limb> magnitude = value._limbs, chunks;
+        while (!magnitude.empty()) {
+            chunks.push_back(divSmall(magnitude, 1000000000u));
+        }
+
+        if (value._negative) {
+            if (first == last) return {last, std::errc::value_too_large};
+            *first++ = '-';
+        }
+        auto result = std::to_chars(first, last, chunks.back());
+        for (size_t i = chunks.size() - 1; i > 0 && result.ec == std::errc(); --i) {
+            if (last - result.ptr < 9) return {last, std::errc::value_too_large};
+            Limb chunk = chunks[i - 1];
+            for (int k = 8; k >= 0; --k, chunk /= 10) result.ptr[k] = static_cast<char>('0' + chunk % 10);
+            result.ptr += 9;
+        }
+        return result;
+    }
+
+    /// Неотрицательное число из строки десятичных цифр, точки пропускаются
+    static BigInteger fromDigits(const char *first, const char *last) {
+        BigInteger result;
+        Limb chunk = 0, scale = 1;
+        for (; first != last; ++first) {
+            if (*first == '.') continue;
+            chunk = chunk * 10 + static_cast<Limb>(*first - '0');
+            scale *= 10;
+            if (scale == 1000000000u) {
+                result = result * BigInteger(scale) + BigInteger(chunk);
+                chunk = 0;
+                scale = 1;
+            }
+        }
+        if (scale != 1) result = result * BigInteger(scale) + BigInteger(chunk);
+        return result;
+    }
+
+private:
+    static constexpr BigInteger make(std::vector<Limb> limbs, bool negative) {
+        BigInteger result;
+        result._limbs = std::move(limbs);
+        trim(result._limbs);
+        result._negative = negative && !result._limbs.empty();
+        return result;
+    }
+
+    static constexpr void trim(std::vector<Limb> &limbs) {
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+
+    /// Модуль, сдвинутый вправо на shift бит; результат должен помещаться в 64 бита
+    [[nodiscard]] constexpr uint64_t topBits(int shift) const {
+        size_t first = static_cast<size_t>(shift) / 32;
+        unsigned __int128 window = 0;
+        for (size_t i = 0; i < 3 && first + i < _limbs.size(); ++i) {
+            window |= static_cast<unsigned __int128>(_limbs[first + i]) << (32 * i);
+        }
+        return static_cast<uint64_t>(window >> (shift % 32));
+    }
+
+    static constexpr int compareMagnitude(const std::vector<Limb> &lhs, const std::vector<Limb> &rhs) {
+        if (lhs.size() != rhs.size()) return lhs.size() < rhs.size() ? -1 : 1;
+        for (size_t i = lhs.size(); i > 0; --i) {
+            if (lhs[i - 1] != rhs[i - 1]) return lhs[i - 1] < rhs[i - 1] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    static constexpr std::vector<Limb> addMagnitude(const std::vector<Limb> &lhs, const std::vector<Limb> &rhs) {
+        const std::vector<Limb> &longer = lhs.size() >= rhs.size() ? lhs : rhs;
+        const std::vector<Limb> &shorter = lhs.size() >= rhs.size() ? rhs : lhs;
+
+        std::vector<Limb> result(longer.size() + 1);
+        DoubleLimb carry = 0;
+        for (size_t i = 0; i < longer.size(); ++i) {
+            carry += longer[i];
+            if (i < shorter.size()) carry += shorter[i];
+            result[i] = static_cast<Limb>(carry);
+            carry >>= 32;
+        }
+        result[longer.size()] = static_cast<Limb>(carry);
+        return result;
+    }
+
+    /// |lhs| - |rhs|, требует |lhs| >= |rhs|
+    static constexpr std::vector<Limb> subMagnitude(const std::vector<Limb> &lhs, const std::vector<Limb> &rhs) {
+        std::vector<Limb> result(lhs.size());
+        int64_t borrow = 0;
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            int64_t t = static_cast<int64_t>(lhs[i]) - borrow - (i < rhs.size() ? rhs[i] : 0);
+            borrow = t < 0;
+            result[i] = static_cast<Limb>(t);
+        }
+        return result;
+    }
+
+    /// Начиная с такой длины меньшего сомножителя умножаем по Карацубе
+    static constexpr size_t karatsubaThreshold = 48;
+
+    static constexpr std::vector<Limb> multiplyMagnitude(const std::vector<Limb> &lhs, const std::vector<Limb> &rhs) {
+        const std::vector<Limb> &a = lhs.size() >= rhs.size() ? lhs : rhs;
+        const std::vector<Limb> &b = lhs.size() >= rhs.size() ? rhs : lhs;
+
+        if (b.size() < karatsubaThreshold) {
+            std::vector<Limb> result(a.size() + b.size());
+            for (size_t i = 0; i < b.size(); ++i) {
+                DoubleLimb carry = 0;
+                for (size_t j = 0; j < a.size(); ++j) {
+                    DoubleLimb t = static_cast<DoubleLimb>(b[i]) * a[j] + result[i + j] + carry;
+                    result[i + j] = static_cast<Limb>(t);
+                    carry = t >> 32;
+                }
+                result[i + a.size()] = static_cast<Limb>(carry);
+            }
+            trim(result);
+            return result;
+        }
+
+        std::vector<Limb> result(a.size() + b.size() + 1);
+        if (2 * b.size() <= a.size()) {
+            // Сильно разные длины: режем длинный сомножитель на куски длины короткого
+            for (size_t begin = 0; begin < a.size(); begin += b.size()) {
+                size_t end = std::min(a.size(), begin + b.size());
+                std::vector<Limb> chunk(a.begin() + begin, a.begin() + end); // NOLINT(*-narrowing-conversions)
+                trim(chunk);
+                addShifted(result, multiplyMagnitude(chunk, b), begin);
+            }
+            trim(result);
+            return result;
+        }
+
+        // a = a1 B^m + a0, b = b1 B^m + b0, a0 b1 + a1 b0 = (a0 + a1)(b0 + b1) - a0 b0 - a1 b1
+        size_t m = a.size() / 2;
+        auto low = [m](const std::vector<Limb> &x) {
+            std::vector<Limb> part(x.begin(), x.begin() + m); // NOLINT(*-narrowing-conversions)
+            trim(part);
+            return part;
+        };
+        auto high = [m](const std::vector<Limb> &x) {
+            return std::vector<Limb>(x.begin() + m, x.end()); // NOLINT(*-narrowing-conversions)
+        };
+        std::vector<Limb> a0 = low(a), a1 = high(a), b0 = low(b), b1 = high(b);
+
+        std::vector<Limb> z0 = multiplyMagnitude(a0, b0), z2 = multiplyMagnitude(a1, b1);
+        std::vector<Limb> sum_a = addMagnitude(a0, a1), sum_b = addMagnitude(b0, b1);
+        trim(sum_a);
+        trim(sum_b);
+        std::vector<Limb> z1 = multiplyMagnitude(sum_a, sum_b);
+        z1 = subMagnitude(z1, z0);
+        trim(z1);
+        z1 = subMagnitude(z1, z2);
+        trim(z1);
+
+        addShifted(result, z0, 0);
+        addShifted(result, z1, m);
+        addShifted(result, z2, 2 * m);
+        trim(result);
+        return result;
+    }
+
+    /// target += value * B^shift, target достаточно длинный
+    static constexpr void addShifted(std::vector<Limb> &target, const std::vector<Limb> &value, size_t shift) {
+        DoubleLimb carry = 0;
+        size_t i = 0;
+        for (; i < value.size(); ++i) {
+            carry += static_cast<DoubleLimb>(target[i + shift]) + value[i];
+            target[i + shift] = static_cast<Limb>(carry);
+            carry >>= 32;
+        }
+        for (; carry != 0; ++i) {
+            carry += target[i + shift];
+            target[i + shift] = static_cast<Limb>(carry);
+            carry >>= 32;
+        }
+    }
+
+    /// Делит модуль на короткое число на месте, возвращает остаток
+    static constexpr Limb divSmall(std::vector<Limb> &magnitude, Limb divisor) {
+        DoubleLimb remainder = 0;
+        for (size_t i = magnitude.size(); i > 0; --i) {
+            DoubleLimb current = (remainder << 32) | magnitude[i - 1];
+            magnitude[i - 1] = static_cast<Limb>(current / divisor);
+            remainder = current % divisor;
+        }
+        trim(magnitude);
+        return static_cast<Limb>(remainder);
+    }
+
+    /// Алгоритм D Кнута, требует |u| >= |v| > 0
+    static constexpr void divModMagnitude(const std::vector<Limb> &u, const std::vector<Limb> &v,
+                                          std::vector<Limb> &quotient, std::vector<Limb> &remainder) {
+        const DoubleLimb base = DoubleLimb(1) << 32;
+        size_t n = v.size(), m = u.size();
+
+        if (n == 1) {
+            quotient = u;
+            remainder = {divSmall(quotient, v[0])};
+            return;
+        }
+
+        // Нормализуем, чтобы старший бит делителя был единицей
+        int s = std::countl_zero(v.back());
+        std::vector<Limb> vn(n), un(m + 1);
+        for (size_t i = n - 1; i > 0; --i) {
+            vn[i] = (v[i] << s) | static_cast<Limb>(static_cast<DoubleLimb>(v[i - 1]) >> (32 - s));
+        }
+        vn[0] = v[0] << s;
+        un[m] = static_cast<Limb>(static_cast<DoubleLimb>(u[m - 1]) >> (32 - s));
+        for (size_t i = m - 1; i > 0; --i) {
+            un[i] = (u[i] << s) | static_cast<Limb>(static_cast<DoubleLimb>(u[i - 1]) >> (32 - s));
+        }
+        un[0] = u[0] << s;
+
+        quotient.assign(m - n + 1, 0);
+        for (size_t j = m - n + 1; j-- > 0;) {
+            DoubleLimb numerator = (static_cast<DoubleLimb>(un[j + n]) << 32) | un[j + n - 1];
+            DoubleLimb qhat = numerator / vn[n - 1];
+            DoubleLimb rhat = numerator - qhat * vn[n - 1];
+
+            while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if (rhat >= base) break;
+            }
+
+            // Вычитаем qhat * vn из текущего окна
+            int64_t borrow = 0, t;
+            for (size_t i = 0; i < n; ++i) {
+                DoubleLimb p = qhat * vn[i];
+                t = static_cast<int64_t>(un[i + j]) - borrow - static_cast<int64_t>(p & 0xFFFFFFFFu);
+                un[i + j] = static_cast<Limb>(t);
+                borrow = static_cast<int64_t>(p >> 32) - (t >> 32);
+            }
+            t = static_cast<int64_t>(un[j + n]) - borrow;
+            un[j + n] = static_cast<Limb>(t);
+
+            quotient[j] = static_cast<Limb>(qhat);
+            if (t < 0) { // перестарались, возвращаем один делитель
+                --quotient[j];
+                DoubleLimb carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    carry += static_cast<DoubleLimb>(un[i + j]) + vn[i];
+                    un[i + j] = static_cast<Limb>(carry);
+                    carry >>= 32;
+                }
+                un[j + n] += static_cast<Limb>(carry);
+            }
+        }
+
+        remainder.assign(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            remainder[i] = (un[i] >> s) | static_cast<Limb>(static_cast<DoubleLimb>(un[i + 1]) << (32 - s));
+        }
+        trim(quotient);
+        trim(remainder);
+    }
+
+    bool _negative = false;
+    std::vector<Limb> _limbs;
+};
+
+/// Дробь из промежуточных значений ленивого выражения, знаменатель любого знака
+struct WideFraction {
+    WideNumberType numerator, denominator;
+};
+
+/// Узел ленивого выражения над Rational, см. lazy()
+template<typename E>
+concept RationalExpression = E::isRationalExpression;
+
+/// Когда BasicRational приводит себя к несократимому виду
+enum class Normalization {
+    Eager,  // в конструкторе и после каждой операции
+    Lazy,   // когда числитель или знаменатель по модулю превышает lazyReduceThreshold
+    Manual, // только по явному вызову reduce()
+};
+
+/// Рациональное число. Пока числитель и знаменатель помещаются в NumberType, хранится в двух машинных словах;
+/// при переполнении (проверяется через WideNumberType) прозрачно переходит на BigInteger
+template<Normalization Policy>
+class BasicRational {
+public:
+
+    /// При меньших значениях произведение двух чисел гарантированно помещается в NumberType
+    static constexpr NumberType lazyReduceThreshold = NumberType(1) << 31;
+
+    constexpr BasicRational(NumberType m, NumberType n) : _numerator(m), _denominator(n) {
+        normalize();
+    }
+
+    // Фикс бед компиляции
+    constexpr BasicRational(int m, int n) : _numerator(m), _denominator(n) {
+        normalize();
+    }
+
+    constexpr BasicRational(NumberType n) : _numerator(n), _denominator(1) {}
+
+    constexpr BasicRational(const BigInteger &m, const BigInteger &n) {
+        *this = fromBig(m, n);
+    }
+
+    /// Отсекает number * precision до целого, см. также fromDouble и approximate
+    constexpr explicit BasicRational(double number, double precision) {
+        _numerator = static_cast<NumberType>(number * precision);
+        _denominator = static_cast<NumberType>(precision);
+        reduce();
+    }
+
+    /// Точное значение double: мантисса, делённая или умноженная на степень двойки
+    static constexpr BasicRational fromDouble(double number) {
+        auto bits = std::bit_cast<uint64_t>(number);
+        int exponent = static_cast<int>((bits >> 52) & 0x7FF);
+        auto mantissa = static_cast<NumberType>(bits & ((uint64_t(1) << 52) - 1));
+        bool negative = (bits >> 63) != 0;
+
+        if (exponent == 0x7FF) throw std::domain_error("Rational from NaN or infinity");
+        if (exponent == 0) {
+            exponent = 1; // денормализованные числа
+        } else {
+            mantissa |= NumberType(1) << 52;
+        }
+        if (mantissa == 0) return {};
+
+        // number = mantissa * 2^(exponent - 1075), мантисса нечётная после сдвига
+        exponent -= 1075;
+        int zeros = std::countr_zero(static_cast<uint64_t>(mantissa));
+        mantissa >>= zeros;
+        exponent += zeros;
+        if (negative) mantissa = -mantissa;
+
+        int mantissa_bits = 64 - std::countl_zero(static_cast<uint64_t>(mantissa < 0 ? -mantissa : mantissa));
+        if (exponent >= 0 && exponent + mantissa_bits < 63) {
+            return {mantissa * (NumberType(1) << exponent), NumberType(1)};
+        }
+        if (exponent < 0 && exponent > -63) {
+            return {mantissa, NumberType(1) << -exponent};
+        }
+
+        if (exponent >= 0) return fromBig(BigInteger(mantissa) * BigInteger::powerOfTwo(exponent), 1);
+        return fromBig(mantissa, BigInteger::powerOfTwo(-exponent));
+    }
+
+    /// Ближайшая к number дробь со знаменателем не больше max_denominator (цепные дроби / дерево Штерна–Броко)
+    static constexpr BasicRational approximate(double number, NumberType max_denominator) {
+        if (max_denominator < 1) throw std::domain_error("Rational max_denominator must be positive");
+
+        BasicRational exact = fromDouble(number);
+        if (!exact._big && exact._denominator <= max_denominator) return exact;
+
+        bool negative = number < 0;
+        if (!exact._big) {
+            NumberType numerator = exact._numerator < 0 ? -exact._numerator : exact._numerator;
+            BasicRational result = limitDenominator<WideNumberType>(numerator, exact._denominator, max_denominator);
+            return negative ? -result : result;
+        }
+        BasicRational result = limitDenominator<BigInteger>(abs(exact._big->numerator), exact._big->denominator,
+                                                            max_denominator);
+        return negative ? -result : result;
+    }
+
+
+    constexpr BasicRational() : _numerator(0), _denominator(1) {}
+
+    /// Ленивое выражение считается целиком в WideNumberType и сокращается один раз;
+    /// при переполнении где-либо внутри пересчитывается обычной арифметикой
+    template<RationalExpression E>
+    constexpr BasicRational(const E &expression) : _numerator(0), _denominator(1) {
+        WideFraction value{};
+        if (expression.evaluateWide(value)) {
+            *this = fromWideReduced(value.numerator, value.denominator);
+        } else {
+            *this = BasicRational(expression.evaluateExact());
+        }
+    }
+
+    template<Normalization Other>
+    constexpr explicit BasicRational(const BasicRational<Other> &other)
+            : _numerator(other._numerator), _denominator(other._denominator) {
+        if (other._big) _big = std::make_unique<BigFraction>(other._big->numerator, other._big->denominator);
+        normalize();
+    }
+
+    // Без тернарного оператора: GCC 12 в constexpr путает время жизни его временных объектов
+    constexpr BasicRational(const BasicRational &other)
+            : _numerator(other._numerator), _denominator(other._denominator) {
+        if (other._big) _big = std::make_unique<BigFraction>(*other._big);
+    }
+
+    constexpr BasicRational(BasicRational &&other) noexcept = default;
+
+    constexpr BasicRational &operator=(const BasicRational &other) {
+        if (this != &other) {
+            _numerator = other._numerator;
+            _denominator = other._denominator;
+            _big.reset();
+            if (other._big) _big = std::make_unique<BigFraction>(*other._big);
+        }
+        return *this;
+    }
+
+    constexpr BasicRational &operator=(BasicRational &&other) noexcept = default;
+
+    constexpr ~BasicRational() = default;
+
+    friend std::ostream &operator<<(std::ostream &out, const BasicRational &r) {
+        if (r._big) {
+            out << r._big->numerator << "/" << r._big->denominator;
+            return out;
+        }
+        out << r._numerator << "/" << r._denominator;
+        return out;
+    }
+
+    constexpr BasicRational operator-() const {
+        if (_big) return fromBig(-_big->numerator, _big->denominator);
+        return fromWide(-static_cast<WideNumberType>(_numerator), _denominator);
+    }
+
+    // prefix increment
+    constexpr BasicRational &operator++() {
+        return *this += BasicRational(1);
+    }
+
+    // postfix increment
+    constexpr BasicRational operator++(int) {
+        BasicRational old = *this; // copy
+        operator++();
+        return old;
+    }
+
+    // prefix decrement
+    constexpr BasicRational &operator--() {
+        return *this -= BasicRational(1);
+    }
+
+    // postfix decrement
+    constexpr BasicRational operator--(int) {
+        BasicRational result = *this; // copy
+        --(*this);
+        return result;
+    }
+
+    constexpr BasicRational operator+(const BasicRational &other) const {
+        if (_big || other._big) return addBig(*this, other, false);
+        // Произведения двух NumberType и их сумма гарантированно помещаются в WideNumberType
+        return fromWide(static_cast<WideNumberType>(_numerator) * other._denominator +
+                        static_cast<WideNumberType>(_denominator) * other._numerator,
+                        static_cast<WideNumberType>(_denominator) * other._denominator);
+    }
+
+    constexpr BasicRational operator-(const BasicRational &other) const {
+        if (_big || other._big) return addBig(*this, other, true);
+        return fromWide(static_cast<WideNumberType>(_numerator) * other._denominator -
+                        static_cast<WideNumberType>(_denominator) * other._numerator,
+                        static_cast<WideNumberType>(_denominator) * other._denominator);
+    }
+
+    constexpr BasicRational operator*(const BasicRational &other) const {
+        if (_big || other._big) {
+            auto [a, b] = reducedBig();
+            auto [c, d] = other.reducedBig();
+            return crossCancelledBigProduct(std::move(a), std::move(b), std::move(c), std::move(d));
+        }
+        return crossCancelledProduct(_numerator, _denominator, other._numerator, other._denominator);
+    }
+
+
+    template<std::integral T>
+    friend constexpr BasicRational operator*(const T factor, const BasicRational &other) {
+        return BasicRational(static_cast<NumberType>(factor)) * other;
+    }
+
+    constexpr BasicRational operator/(const BasicRational &other) const {
+        if (_big || other._big) {
+            auto [a, b] = reducedBig();
+            auto [c, d] = other.reducedBig();
+            return crossCancelledBigProduct(std::move(a), std::move(b), std::move(d), std::move(c));
+        }
+        return crossCancelledProduct(_numerator, _denominator, other._denominator, other._numerator);
+    }
+
+    constexpr BasicRational &operator+=(const BasicRational &other) {
+        return *this = *this + other;
+    }
+
+    constexpr BasicRational &operator-=(const BasicRational &other) {
+        return *this = *this - other;
+    }
+
+    constexpr BasicRational &operator*=(const BasicRational &other) {
+        return *this = *this * other;
+    }
+
+
+    constexpr BasicRational &operator/=(const BasicRational &other) {
+
+        if (this == &other) {
+            _numerator = 1;
+            _denominator = 1;
+            _big.reset();
+            return *this;
+        }
+
+        return *this = *this / other;
+    }
+
+    constexpr bool operator==(const BasicRational &other) const {
+        return (*this <=> other) == 0;
+    }
+
+    /// Сравнение по значению, знаменатели могут быть любого знака
+    constexpr std::strong_ordering operator<=>(const BasicRational &other) const {
+        int sign = (_big ? _big->denominator.isNegative() : _denominator < 0) !=
+                   (other._big ? other._big->denominator.isNegative() : other._denominator < 0) ? -1 : 1;
+        if (_big || other._big) {
+            auto cmp = bigNumerator() * other.bigDenominator() <=> other.bigNumerator() * bigDenominator();
+            return sign > 0 ? cmp : 0 <=> cmp;
+        }
+        auto cmp = static_cast<WideNumberType>(_numerator) * other._denominator <=>
+                   static_cast<WideNumberType>(other._numerator) * _denominator;
+        return sign > 0 ? cmp : 0 <=> cmp;
+    }
+
+
+    friend constexpr BasicRational intPow(BasicRational r, unsigned long long power) {
+        return BinaryPower(r, power);
+    }
+
+    friend BasicRational pow(BasicRational r, double power) {
+        if (r._big) {
+            return {static_cast<NumberType>(pow(r._big->numerator.toDouble(), power)),
+                    static_cast<NumberType>(pow(r._big->denominator.toDouble(), power))};
+        }
+        return {static_cast<NumberType>(pow(r._numerator, power)),
+                static_cast<NumberType>( pow(r._denominator, power))};
+    }
+
+
+    constexpr explicit operator double() const {
+        if (_big) return BigInteger::ratioToDouble(_big->numerator, _big->denominator);
+        return static_cast<double >(_numerator) / static_cast<double >(_denominator);
+    }
+
+
+    /// false, если число перешло на BigInteger
+    [[nodiscard]] constexpr bool isSmall() const {
+        return !_big;
+    }
+
+    [[nodiscard]] constexpr NumberType numerator() const {
+        if (_big) throw std::overflow_error("Rational numerator does not fit NumberType");
+        return _numerator;
+    }
+
+    [[nodiscard]] constexpr NumberType denominator() const {
+        if (_big) throw std::overflow_error("Rational denominator does not fit NumberType");
+        return _denominator;
+    }
+
+    [[nodiscard]] constexpr BigInteger bigNumerator() const {
+        if (_big) return _big->numerator;
+        return _numerator;
+    }
+
+    [[nodiscard]] constexpr BigInteger bigDenominator() const {
+        if (_big) return _big->denominator;
+        return _denominator;
+    }
+
+
+    /// Приводит к несократимому виду
+    constexpr void reduce() {
+        if (_big) return; // длинное представление всегда несократимо
+
+        NumberType t = gcd(_numerator, _denominator);
+        if (t == 0) return;
+        _numerator /= t;
+        _denominator /= t;
+
+
+        if (_denominator < static_cast<NumberType>(0)) {
+            _denominator = -_denominator;
+            _numerator = -_numerator;
+        }
+    }
+
+private:
+    template<Normalization> friend
+    class BasicRational;
+
+    struct BigFraction {
+        BigInteger numerator, denominator;
+    };
+
+    /// Сокращает согласно Policy; длинное представление и так всегда несократимо
+    constexpr void normalize() {
+        if constexpr (Policy == Normalization::Eager) {
+            reduce();
+        } else if constexpr (Policy == Normalization::Lazy) {
+            if (_numerator >= lazyReduceThreshold || _numerator <= -lazyReduceThreshold ||
+                _denominator >= lazyReduceThreshold || _denominator <= -lazyReduceThreshold) {
+                reduce();
+            }
+        }
+    }
+
+    /// (a / b) * (c / d) с предварительным сокращением a с d и c с b: сомножители остаются маленькими
+    static constexpr BasicRational crossCancelledProduct(NumberType a, NumberType b, NumberType c, NumberType d) {
+        NumberType ad = gcd(a, d), cb = gcd(c, b);
+        if (ad > 1) {
+            a /= ad;
+            d /= ad;
+        }
+        if (cb > 1) {
+            c /= cb;
+            b /= cb;
+        }
+        return fromWide(static_cast<WideNumberType>(a) * c, static_cast<WideNumberType>(b) * d);
+    }
+
+    /// Наилучшее приближение n / d > 0 со знаменателем не больше max_denominator,
+    /// Int - WideNumberType или BigInteger
+    template<typename Int>
+    static constexpr BasicRational limitDenominator(Int n, Int d, Int max_denominator) {
+        const Int original_denominator = d;
+        Int p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+        while (true) {
+            Int a = n / d;
+            Int q2 = q0 + a * q1;
+            if (q2 > max_denominator) break;
+
+            Int p2 = p0 + a * p1;
+            p0 = p1;
+            q0 = q1;
+            p1 = p2;
+            q1 = q2;
+
+            Int remainder = n - a * d;
+            n = d;
+            d = remainder;
+            if (d == 0) break;
+        }
+
+        // Кандидаты: подходящая дробь p1 / q1 и промежуточная (p0 + k p1) / (q0 + k q1)
+        Int k = (max_denominator - q0) / q1;
+        Int two = 2;
+        bool convergent = d == 0 || two * d * (q0 + k * q1) <= original_denominator;
+        Int numerator = convergent ? p1 : p0 + k * p1, denominator = convergent ? q1 : q0 + k * q1;
+
+        if constexpr (std::is_same_v<Int, BigInteger>) {
+            return fromBig(numerator, denominator);
+        } else {
+            return fromWide(numerator, denominator);
+        }
+    }
+
+    /// Несократимые числитель и знаменатель (больше нуля) в виде BigInteger
+    [[nodiscard]] constexpr std::pair<BigInteger, BigInteger> reducedBig() const {
+        if (_big) return {_big->numerator, _big->denominator};
+
+        WideNumberType numerator = _numerator, denominator = _denominator;
+        WideNumberType t = gcd(numerator, denominator);
+        if (t > 1) {
+            numerator /= t;
+            denominator /= t;
+        }
+        if (denominator < 0) {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+        return {BigInteger::fromWide(numerator), BigInteger::fromWide(denominator)};
+    }
+
+    /// Сложение по Кнуту: gcd считается от знаменателей, а не от полного результата
+    static constexpr BasicRational addBig(const BasicRational &lhs, const BasicRational &rhs, bool subtract) {
+        auto [a, b] = lhs.reducedBig();
+        auto [c, d] = rhs.reducedBig();
+        if (subtract) c = -c;
+
+        BigInteger g = gcd(b, d);
+        if (g == 1) return fromBigReduced(a * d + c * b, b * d);
+
+        BigInteger b_part = b / g, d_part = d / g;
+        BigInteger numerator = a * d_part + c * b_part;
+        BigInteger g2 = gcd(numerator, g);
+        if (g2 == 1) return fromBigReduced(std::move(numerator), b_part * d);
+        return fromBigReduced(numerator / g2, b_part * (d / g2));
+    }
+
+    /// (a / b) * (c / d) для несократимых дробей: после сокращения a с d и c с b результат несократим
+    static constexpr BasicRational crossCancelledBigProduct(BigInteger a, BigInteger b, BigInteger c, BigInteger d) {
+        BigInteger ad = gcd(a, d), cb = gcd(c, b);
+        if (ad > 1) {
+            a /= ad;
+            d /= ad;
+        }
+        if (cb > 1) {
+            c /= cb;
+            b /= cb;
+        }
+        BigInteger denominator = b * d;
+        if (denominator.isNegative()) return fromBigReduced(-(a * c), -denominator);
+        return fromBigReduced(a * c, std::move(denominator));
+    }
+
+    /// Результат быстрого пути. Без переполнения сокращается согласно Policy;
+    /// иначе сокращается и при необходимости переходит на BigInteger
+    static constexpr BasicRational fromWide(WideNumberType numerator, WideNumberType denominator) {
+        if (fitsNumberType(numerator) && fitsNumberType(denominator)) {
+            return {static_cast<NumberType>(numerator), static_cast<NumberType>(denominator)}; // с normalize()
+        }
+
+        return fromWideReduced(numerator, denominator);
+    }
+
+    /// Сокращает и выбирает представление, уже без normalize()
+    static constexpr BasicRational fromWideReduced(WideNumberType numerator, WideNumberType denominator) {
+        WideNumberType t = gcd(numerator, denominator);
+        if (t != 0) {
+            numerator /= t;
+            denominator /= t;
+        }
+        if (denominator < 0) {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+
+        BasicRational result;
+        if (fitsNumberType(numerator) && fitsNumberType(denominator)) {
+            result._numerator = static_cast<NumberType>(numerator);
+            result._denominator = static_cast<NumberType>(denominator);
+            return result;
+        }
+
+        result._big = std::make_unique<BigFraction>(
+                BigFraction{BigInteger::fromWide(numerator), BigInteger::fromWide(denominator)}
+        );
+        return result;
+    }
+
+    /// Длинный путь: всегда сокращаем и возвращаемся к быстрому представлению, когда это возможно
+    static constexpr BasicRational fromBig(BigInteger numerator, BigInteger denominator) {
+        BigInteger t = gcd(numerator, denominator);
+        if (!t.isZero()) {
+            numerator /= t;
+            denominator /= t;
+        }
+        if (denominator.isNegative()) {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+
+        return fromBigReduced(std::move(numerator), std::move(denominator));
+    }
+
+    /// Выбирает представление для уже несократимой дроби со знаменателем больше нуля
+    static constexpr BasicRational fromBigReduced(BigInteger numerator, BigInteger denominator) {
+        if (numerator.fitsNumberType() && denominator.fitsNumberType()) {
+            BasicRational result;
+            result._numerator = numerator.toNumberType();
+            result._denominator = denominator.toNumberType();
+            return result;
+        }
+
+        BasicRational result;
+        result._big = std::make_unique<BigFraction>(BigFraction{std::move(numerator), std::move(denominator)});
+        return result;
+    }
+
+    static constexpr bool fitsNumberType(WideNumberType value) {
+        return value >= std::numeric_limits<NumberType>::min() && value <= std::numeric_limits<NumberType>::max();
+    }
+
+    NumberType _numerator, _denominator;
+    std::unique_ptr<BigFraction> _big; // nullptr на быстром пути
+};
+
+using Rational = BasicRational<Normalization::Lazy>;
+
+/// Лист выражения: ссылка на Rational, который должен жить до конца выражения
+template<Normalization Policy>
+struct RationalReference {
+    static constexpr bool isRationalExpression = true;
+
+    const BasicRational<Policy> &value;
+
+    constexpr bool evaluateWide(WideFraction &out) const {
+        if (!value.isSmall()) return false;
+        out = {value.numerator(), value.denominator()};
+        return true;
+    }
+
+    [[nodiscard]] constexpr Rational evaluateExact() const {
+        return Rational(value);
+    }
+};
+
+/// Лист выражения: целое число
+struct IntegerConstant {
+    static constexpr bool isRationalExpression = true;
+
+    NumberType value;
+
+    constexpr bool evaluateWide(WideFraction &out) const {
+        out = {value, 1};
+        return true;
+    }
+
+    [[nodiscard]] constexpr Rational evaluateExact() const {
+        return value;
+    }
+};
+
+/// Операции над промежуточными дробями с проверкой переполнения WideNumberType
+struct RationalAdd {
+    static constexpr bool wide(const WideFraction &a, const WideFraction &b, WideFraction &out) {
+        WideNumberType ad, bc;
+        return !__builtin_mul_overflow(a.numerator, b.denominator, &ad) &&
+               !__builtin_mul_overflow(b.numerator, a.denominator, &bc) &&
+               !__builtin_add_overflow(ad, bc, &out.numerator) &&
+               !__builtin_mul_overflow(a.denominator, b.denominator, &out.denominator);
+    }
+
+    static constexpr Rational exact(const Rational &a, const Rational &b) {
+        return a + b;
+    }
+};
+
+struct RationalSubtract {
+    static constexpr bool wide(const WideFraction &a, const WideFraction &b, WideFraction &out) {
+        WideNumberType ad, bc;
+        return !__builtin_mul_overflow(a.numerator, b.denominator, &ad) &&
+               !__builtin_mul_overflow(b.numerator, a.denominator, &bc) &&
+               !__builtin_sub_overflow(ad, bc, &out.numerator) &&
+               !__builtin_mul_overflow(a.denominator, b.denominator, &out.denominator);
+    }
+
+    static constexpr Rational exact(const Rational &a, const Rational &b) {
+        return a - b;
+    }
+};
+
+struct RationalMultiply {
+    static constexpr bool wide(const WideFraction &a, const WideFraction &b, WideFraction &out) {
+        return !__builtin_mul_overflow(a.numerator, b.numerator, &out.numerator) &&
+               !__builtin_mul_overflow(a.denominator, b.denominator, &out.denominator);
+    }
+
+    static constexpr Rational exact(const Rational &a, const Rational &b) {
+        return a * b;
+    }
+};
+
+struct RationalDivide {
+    static constexpr bool wide(const WideFraction &a, const WideFraction &b, WideFraction &out) {
+        return !__builtin_mul_overflow(a.numerator, b.denominator, &out.numerator) &&
+               !__builtin_mul_overflow(a.denominator, b.numerator, &out.denominator);
+    }
+
+    static constexpr Rational exact(const Rational &a, const Rational &b) {
+        return a / b;
+    }
+};
+
+/// Узел выражения: бинарная операция Operation над подвыражениями
+template<typename Operation, RationalExpression L, RationalExpression R>
+struct RationalBinaryExpression {
+    static constexpr bool isRationalExpression = true;
+
+    L lhs;
+    R rhs;
+
+    constexpr bool evaluateWide(WideFraction &out) const {
+        WideFraction a{}, b{};
+        return lhs.evaluateWide(a) && rhs.evaluateWide(b) && Operation::wide(a, b, out);
+    }
+
+    [[nodiscard]] constexpr Rational evaluateExact() const {
+        return Operation::exact(lhs.evaluateExact(), rhs.evaluateExact());
+    }
+};
+
+template<RationalExpression E>
+struct RationalNegation {
+    static constexpr bool isRationalExpression = true;
+
+    E operand;
+
+    constexpr bool evaluateWide(WideFraction &out) const {
+        return operand.evaluateWide(out) && !__builtin_sub_overflow(0, out.numerator, &out.numerator);
+    }
+
+    [[nodiscard]] constexpr Rational evaluateExact() const {
+        return -operand.evaluateExact();
+    }
+};
+
+/// Начинает ленивое выражение: lazy(a) * b - c считается при присваивании в Rational
+/// одним общим числителем и знаменателем с одним сокращением вместо сокращения после каждой операции.
+/// Выражение хранит ссылки на операнды, поэтому его нельзя сохранять дольше них
+template<Normalization Policy>
+constexpr RationalReference<Policy> lazy(const BasicRational<Policy> &value) {
+    return {value};
+}
+
+template<RationalExpression E>
+constexpr const E &asExpression(const E &expression) {
+    return expression;
+}
+
+template<Normalization Policy>
+constexpr RationalReference<Policy> asExpression(const BasicRational<Policy> &value) {
+    return {value};
+}
+
+template<std::integral T>
+constexpr IntegerConstant asExpression(T value) {
+    return {static_cast<NumberType>(value)};
+}
+
+/// Операнд ленивого выражения: выражение, Rational или целое число
+template<typename T>
+concept RationalOperand = requires(const T &value) { asExpression(value); };
+
+/// Хотя бы один из операндов уже выражение, иначе работают обычные операторы Rational
+template<typename L, typename R>
+concept LazyOperands = RationalOperand<L> && RationalOperand<R> && (RationalExpression<L> || RationalExpression<R>);
+
+template<typename Operation, typename L, typename R>
+constexpr auto makeBinaryExpression(const L &lhs, const R &rhs) {
+    using LeftExpression = std::remove_cvref_t<decltype(asExpression(lhs))>;
+    using RightExpression = std::remove_cvref_t<decltype(asExpression(rhs))>;
+    return RationalBinaryExpression<Operation, LeftExpression, RightExpression>{asExpression(lhs), asExpression(rhs)};
+}
+
+template<typename L, typename R> requires LazyOperands<L, R>
+constexpr auto operator+(const L &lhs, const R &rhs) {
+    return makeBinaryExpression<RationalAdd>(lhs, rhs);
+}
+
+template<typename L, typename R> requires LazyOperands<L, R>
+constexpr auto operator-(const L &lhs, const R &rhs) {
+    return makeBinaryExpression<RationalSubtract>(lhs, rhs);
+}
+
+template<typename L, typename R> requires LazyOperands<L, R>
+constexpr auto operator*(const L &lhs, const R &rhs) {
+    return makeBinaryExpression<RationalMultiply>(lhs, rhs);
+}
+
+template<typename L, typename R> requires LazyOperands<L, R>
+constexpr auto operator/(const L &lhs, const R &rhs) {
+    return makeBinaryExpression<RationalDivide>(lhs, rhs);
+}
+
+template<RationalExpression E>
+constexpr RationalNegation<E> operator-(const E &expression) {
+    return {expression};
+}
+
+
+/// Числа Бернулли B_0, B_1, ... (B_1 = +1/2, как в рекурсии Акиямы–Танигавы).
+/// Для набора простых p ~ 2^31 параллельно считаются B_2k mod p обращением ряда (x/2) cth(x/2) = sh / ch,
+/// затем числители восстанавливаются по китайской теореме об остатках (Гарнер), а знаменатели известны
+/// из теоремы фон Штаудта–Клаузена. Посчитанные числа хранятся до конца программы
+class BernoulliTable {
+public:
+    /// Ссылка остаётся валидной до конца программы
+    static const Rational &get(size_t k) {
+        reserve(k);
+        std::lock_guard lock(_mutex);
+        return _table[k];
+    }
+
+    /// Гарантирует, что B_0..B_n уже посчитаны
+    static void reserve(size_t n) {
+        std::lock_guard lock(_mutex);
+        if (n < _table.size()) return;
+
+        // Пересчёт с нуля дешевле дозаполнения, поэтому растём геометрически
+        std::vector<Rational> numbers = compute(std::max(n, 2 * _table.size()));
+        for (size_t k = _table.size(); k < numbers.size(); ++k) {
+            _table.push_back(std::move(numbers[k]));
+        }
+    }
+
+private:
+    using Residue = uint64_t;
+
+    static std::vector<Rational> compute(size_t n) {
+        std::vector<Rational> numbers(n + 1);
+        numbers[0] = 1;
+        if (n >= 1) numbers[1] = {1, 2};
+        size_t half = n / 2; // считаем B_2..B_2half, нечётные начиная с B_3 нулевые
+        if (half == 0) return numbers;
+
+        // Знаменатели по фон Штаудту–Клаузену: произведение простых q, для которых (q - 1) | 2m
+        std::vector<uint32_t> small_primes;
+        for (uint32_t q = 2; q <= n + 1; ++q) {
+            if (isPrime(q)) small_primes.push_back(q);
+        }
+        std::vector<std::vector<uint32_t>> denominator_primes(half + 1);
+        std::vector<double> denominator_bits(half + 1);
+        for (uint32_t q: small_primes) {
+            for (size_t k = (q - 1) % 2 == 0 ? q - 1 : 2; k <= 2 * half; k += (q - 1) % 2 == 0 ? q - 1 : 2) {
+                denominator_primes[k / 2].push_back(q);
+                denominator_bits[k / 2] += std::log2(q);
+            }
+        }
+
+        // |B_2m| <= 4 (2m)! / (2pi)^2m; модулей должно хватить на удвоенный числитель со знаком
+        std::vector<size_t> moduli_count(half + 1);
+        std::vector<Residue> moduli;
+        double available_bits = 0.0;
+        for (size_t m = 1; m <= half; ++m) {
+            double k = 2.0 * static_cast<double>(m);
+            double bits = denominator_bits[m] + 3.0 + (std::lgamma(k + 1) - k * std::log(2 * std::numbers::pi)) / std::log(2.0);
+            while (available_bits < bits + 1.0) {
+                Residue p = moduli.empty() ? (Residue(1) << 31) - 1 : moduli.back() - 2;
+                while (!isPrime(p)) p -= 2;
+                moduli.push_back(p);
+                available_bits += std::log2(static_cast<double>(p));
+            }
+            moduli_count[m] = moduli.size();
+        }
+
+        // residues[i][m] = (числитель B_2m) mod moduli[i]
+        std::vector<std::vector<Residue>> residues(moduli.size());
+        parallelFor(moduli.size(), [&](size_t i) {
+            residues[i] = numeratorResidues(half, moduli[i], denominator_primes);
+        });
+
+        // Восстановление по КТО: x = v_0 + v_1 p_0 + v_2 p_0 p_1 + ...
+        std::vector<Residue> prefix_inverse(moduli.size());
+        for (size_t i = 1; i < moduli.size(); ++i) {
+            Residue prefix = 1;
+            for (size_t j = 0; j < i; ++j) prefix = prefix * moduli[j] % moduli[i];
+            prefix_inverse[i] = powMod(prefix, moduli[i] - 2, moduli[i]);
+        }
+        std::vector<BigInteger> prefix_product(moduli.size() + 1);
+        prefix_product[0] = 1;
+        for (size_t i = 0; i < moduli.size(); ++i) {
+            prefix_product[i + 1] = prefix_product[i] * BigInteger(static_cast<NumberType>(moduli[i]));
+        }
+
+        parallelFor(half, [&](size_t index) {
+            size_t m = index + 1, count = moduli_count[m];
+            std::vector<Residue> v(count);
+            for (size_t i = 0; i < count; ++i) {
+                Residue t = 0;
+                for (size_t j = i; j-- > 0;) t = (t * moduli[j] + v[j]) % moduli[i];
+                v[i] = (residues[i][m] + moduli[i] - t) % moduli[i] * (i == 0 ? 1 : prefix_inverse[i]) % moduli[i];
+            }
+
+            BigInteger numerator;
+            for (size_t i = count; i-- > 0;) {
+                numerator = numerator * BigInteger(static_cast<NumberType>(moduli[i])) +
+                            BigInteger(static_cast<NumberType>(v[i]));
+            }
+            if (numerator + numerator > prefix_product[count]) numerator -= prefix_product[count];
+
+            BigInteger denominator = 1;
+            for (uint32_t q: denominator_primes[m]) denominator *= BigInteger(static_cast<NumberType>(q));
+            numbers[2 * m] = Rational(numerator, denominator);
+        });
+
+        return numbers;
+    }
+
+    /// Числители B_2m mod p для m = 0..half, p > 2 * half + 1
+    static std::vector<Residue> numeratorResidues(size_t half, Residue p,
+                                                  const std::vector<std::vector<uint32_t>> &denominator_primes) {
+        size_t n = 2 * half + 1;
+        std::vector<Residue> factorial(n + 1), inverse_factorial(n + 1);
+        factorial[0] = 1;
+        for (size_t i = 1; i <= n; ++i) factorial[i] = factorial[i - 1] * i % p;
+        inverse_factorial[n] = powMod(factorial[n], p - 2, p);
+        for (size_t i = n; i > 0; --i) inverse_factorial[i - 1] = inverse_factorial[i] * i % p;
+
+        // ch(x/2) = sum C_m y^m, sh(x/2) / (x/2) = sum S_m y^m, y = x^2
+        Residue inverse_four = powMod(4, p - 2, p), power = 1;
+        std::vector<Residue> cosh_coefs(half + 1), sinh_coefs(half + 1);
+        for (size_t m = 0; m <= half; ++m) {
+            cosh_coefs[m] = power * inverse_factorial[2 * m] % p;
+            sinh_coefs[m] = power * inverse_factorial[2 * m + 1] % p;
+            power = power * inverse_four % p;
+        }
+
+        // E = C / S, S_0 = 1; B_2m = (2m)! E_m
+        std::vector<Residue> quotient(half + 1), result(half + 1);
+        for (size_t m = 0; m <= half; ++m) {
+            unsigned __int128 sum = 0; // до 2^62 * half, делим один раз в конце
+            for (size_t j = 1; j <= m; ++j) sum += sinh_coefs[j] * quotient[m - j];
+            quotient[m] = (cosh_coefs[m] + p - static_cast<Residue>(sum % p)) % p;
+
+            Residue numerator = factorial[2 * m] * quotient[m] % p;
+            for (uint32_t q: denominator_primes[m]) numerator = numerator * q % p;
+            result[m] = numerator;
+        }
+        return result;
+    }
+
+    /// Вызывает body(i) для i = 0..count-1 на всех ядрах
+    template<typename F>
+    static void parallelFor(size_t count, F body) {
+        size_t threads_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < threads_count; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = t; i < count; i += threads_count) body(i);
+            });
+        }
+        for (size_t i = 0; i < count; i += threads_count) body(i);
+        for (auto &thread: threads) thread.join();
+    }
+
+    static Residue powMod(Residue base, Residue exponent, Residue modulus) {
+        Residue result = 1;
+        base %= modulus;
+        while (exponent != 0) {
+            if ((exponent & 1) != 0) result = result * base % modulus;
+            base = base * base % modulus;
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    /// Детерминированный тест Миллера–Рабина для чисел меньше 2^32
+    static bool isPrime(Residue n) {
+        if (n < 2) return false;
+        for (Residue q: {2u, 3u, 5u, 7u, 61u}) {
+            if (n % q == 0) return n == q;
+        }
+
+        Residue d = n - 1;
+        int s = trailingZeros(d);
+        d >>= s;
+        for (Residue a: {2u, 7u, 61u}) {
+            Residue x = powMod(a, d, n);
+            if (x == 1 || x == n - 1) continue;
+            bool composite = true;
+            for (int r = 1; r < s && composite; ++r) {
+                x = x * x % n;
+                composite = x != n - 1;
+            }
+            if (composite) return false;
+        }
+        return true;
+    }
+
+    static inline std::mutex _mutex;
+    static inline std::deque<Rational> _table; // deque не инвалидирует ссылки при росте
+};
+
+/// Возвращает первых n чисел Бернулли, начиная с первого
+inline std::vector<Rational> getBernoulliNumbers(const int n) {
+    BernoulliTable::reserve(n);
+
+    std::vector<Rational> numbers(n);
+    for (int i = 1; i <= n; ++i) {
+        numbers[i - 1] = BernoulliTable::get(i);
+    }
+
+    return numbers;
+}
+
+
+/// B_0..B_N при компиляции рекурсией Акиямы–Танигавы (B_1 = +1/2).
+/// Промежуточные значения могут быть любыми, результат должен помещаться в NumberType
+template<size_t N>
+constexpr std::array<Rational, N + 1> bernoulliNumbers() {
+    std::array<Rational, N + 1> numbers, buffer;
+    for (size_t i = 0; i <= N; ++i) {
+        buffer[i] = {NumberType(1), static_cast<NumberType>(i + 1)};
+        for (size_t j = i; j > 0; --j) {
+            buffer[j - 1] = j * (lazy(buffer[j - 1]) - buffer[j]);
+        }
+
+        numbers[i] = buffer[0];
+    }
+
+    return numbers;
+}
+
+/// Коэффициенты ряда Тейлора tg(x) до x^N включительно:
+/// при x^(2n-1) стоит (-1)^(n-1) 2^2n (2^2n - 1) B_2n / (2n)!
+template<size_t N>
+constexpr std::array<Rational, N + 1> tanTaylorCoefficients() {
+    constexpr auto bernoulli = bernoulliNumbers<N + 1>();
+
+    std::array<Rational, N + 1> coefficients;
+    Rational factorial = 1;
+    for (size_t k = 1; k <= N; ++k) {
+        factorial *= Rational(static_cast<NumberType>(k + 1));
+        if (k % 2 == 0) continue;
+
+        Rational power = BinaryPower(Rational(4), (k + 1) / 2);
+        Rational coefficient = power * (power - Rational(1)) * bernoulli[k + 1] / factorial;
+        coefficients[k] = (k / 2) % 2 == 0 ? coefficient : -coefficient;
+        coefficients[k].reduce();
+    }
+
+    return coefficients;
+}
+
+/// Многочлен с коэффициентами из constexpr-таблицы (Coefficients[k] при x^k) по схеме Горнера.
+/// Коэффициенты переводятся в double при компиляции
+template<const auto &Coefficients>
+constexpr double evaluateTaylor(double x) {
+    constexpr size_t size = Coefficients.size();
+    constexpr std::array<double, size> values = [] {
+        std::array<double, size> result{};
+        for (size_t k = 0; k < size; ++k) result[k] = static_cast<double>(Coefficients[k]);
+        return result;
+    }();
+
+    double result = 0.0;
+    for (size_t k = size; k > 0; --k) {
+        result = result * x + values[k - 1];
+    }
+    return result;
+}
+
+constexpr auto bernoulli16 = bernoulliNumbers<16>();
+constexpr auto tanTaylor17 = tanTaylorCoefficients<17>();
+
+
+/// Свёртка values[first, first + count) сбалансированным деревом: соседние частичные результаты
+/// одного размера, поэтому и числители со знаменателями растут равномерно.
+/// На верхних parallel_depth уровнях левая половина считается в отдельном потоке
+template<typename Range, typename Operation>
+Rational treeReduce(const Range &values, size_t first, size_t count, Operation operation, int parallel_depth) {
+    if (count == 1) return Rational(std::ranges::begin(values)[first]);
+
+    size_t half = count / 2;
+    Rational left, right;
+    if (parallel_depth > 0) {
+        std::thread worker([&] { left = treeReduce(values, first, half, operation, parallel_depth - 1); });
+        right = treeReduce(values, first + half, count - half, operation, parallel_depth - 1);
+        worker.join();
+    } else {
+        left = treeReduce(values, first, half, operation, 0);
+        right = treeReduce(values, first + half, count - half, operation, 0);
+    }
+
+    return operation(left, right);
+}
+
+/// Глубина дерева, на которой заняты все ядра
+inline int parallelTreeDepth(size_t count) {
+    int depth = 0;
+    while ((size_t(1) << depth) < std::thread::hardware_concurrency() && (size_t(64) << depth) < count) ++depth;
+    return depth;
+}
+
+/// Точная сумма элементов диапазона, приведённая к несократимому виду.
+/// Форма дерева не зависит от числа потоков, так что результат тот же, что и у последовательного сложения
+template<std::ranges::random_access_range Range>
+Rational sum(const Range &values) {
+    auto count = static_cast<size_t>(std::ranges::size(values));
+    if (count == 0) return {};
+
+    Rational result = treeReduce(values, 0, count, std::plus<Rational>(), parallelTreeDepth(count));
+    result.reduce();
+    return result;
+}
+
+/// Точное произведение элементов диапазона, см. sum
+template<std::ranges::random_access_range Range>
+Rational product(const Range &values) {
+    auto count = static_cast<size_t>(std::ranges::size(values));
+    if (count == 0) return 1;
+
+    Rational result = treeReduce(values, 0, count, std::multiplies<Rational>(), parallelTreeDepth(count));
+    result.reduce();
+    return result;
+}
+
+
+/// Массив рациональных чисел в виде структуры массивов: числители и знаменатели лежат в отдельных
+/// непрерывных массивах. Пока значения лежат в [-2^31, 2^31), арифметика и сокращение идут по
+/// NumberLanes::width элементов за раз (AVX2 или SSE2), иначе поэлементно через Rational.
+/// Предусловие: результаты помещаются в NumberType. Если сумма или произведение не помещается и после
+/// сокращения, кидается std::overflow_error - такие значения храните в std::vector<Rational>
+class RationalArray {
+public:
+    RationalArray() = default;
+
+    explicit RationalArray(size_t size) : _numerators(size, 0), _denominators(size, 1) {}
+
+    explicit RationalArray(const std::vector<Rational> &values) : RationalArray(values.size()) {
+        for (size_t i = 0; i < values.size(); ++i) set(i, values[i]);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _numerators.size();
+    }
+
+    Rational operator[](size_t i) const {
+        return {_numerators[i], _denominators[i]};
+    }
+
+    void set(size_t i, const Rational &value) {
+        _numerators[i] = value.numerator();
+        _denominators[i] = value.denominator();
+    }
+
+    void push_back(const Rational &value) {
+        _numerators.push_back(value.numerator());
+        _denominators.push_back(value.denominator());
+    }
+
+    [[nodiscard]] std::vector<Rational> toVector() const {
+        std::vector<Rational> result(size());
+        for (size_t i = 0; i < size(); ++i) result[i] = (*this)[i];
+        return result;
+    }
+
+    [[nodiscard]] const NumberType *numerators() const {
+        return _numerators.data();
+    }
+
+    [[nodiscard]] const NumberType *denominators() const {
+        return _denominators.data();
+    }
+
+    RationalArray operator+(const RationalArray &other) const {
+        return apply(other, std::plus<Rational>(), [](auto a, auto b, auto c, auto d, auto &n, auto &m) {
+            n = a * d + b * c;
+            m = b * d;
+        });
+    }
+
+    RationalArray operator-(const RationalArray &other) const {
+        return apply(other, std::minus<Rational>(), [](auto a, auto b, auto c, auto d, auto &n, auto &m) {
+            n = a * d - b * c;
+            m = b * d;
+        });
+    }
+
+    RationalArray operator*(const RationalArray &other) const {
+        return apply(other, std::multiplies<Rational>(), [](auto a, auto b, auto c, auto d, auto &n, auto &m) {
+            n = a * c;
+            m = b * d;
+        });
+    }
+
+    RationalArray operator/(const RationalArray &other) const {
+        return apply(other, std::divides<Rational>(), [](auto a, auto b, auto c, auto d, auto &n, auto &m) {
+            // знак делителя переносим в числитель без ветвления: s = 0 или -1, (x ^ s) - s = x или -x
+            auto s = c >> 63;
+            n = ((a * d) ^ s) - s;
+            m = ((b * c) ^ s) - s;
+        });
+    }
+
+    RationalArray &operator+=(const RationalArray &other) {
+        return *this = *this + other;
+    }
+
+    RationalArray &operator-=(const RationalArray &other) {
+        return *this = *this - other;
+    }
+
+    RationalArray &operator*=(const RationalArray &other) {
+        return *this = *this * other;
+    }
+
+    RationalArray &operator/=(const RationalArray &other) {
+        return *this = *this / other;
+    }
+
+    /// Приводит все элементы к несократимому виду, gcd считается для блока элементов одновременно
+    void reduce() {
+        const size_t block = 256;
+        NumberType u[block], v[block];
+        int shift[block];
+
+        for (size_t begin = 0; begin < size(); begin += block) {
+            size_t count = std::min(block, size() - begin);
+            NumberType *numerators = _numerators.data() + begin, *denominators = _denominators.data() + begin;
+
+            // Готовим пары так, чтобы u было нечётным, а v без младших нулей (или оба нуля)
+            uint64_t bits_mask = 0;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t a = magnitude(numerators[i]), b = magnitude(denominators[i]);
+                if (a == 0) std::swap(a, b);
+                shift[i] = a == 0 ? 0 : std::countr_zero(a | b);
+                a >>= shift[i];
+                b >>= shift[i];
+                if ((a & 1) == 0) std::swap(a, b);
+                if (b != 0) b >>= std::countr_zero(b); // теперь оба меньше 2^63
+                u[i] = static_cast<NumberType>(a);
+                v[i] = static_cast<NumberType>(b);
+                bits_mask |= a | b;
+            }
+
+            // Каждый шаг уменьшает суммарную длину u и v хотя бы на бит
+            int steps = 2 * (64 - std::countl_zero(bits_mask));
+            size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            for (; i + NumberLanes::width <= count; i += NumberLanes::width) {
+                NumberLanes uu = NumberLanes::load(u + i), vv = NumberLanes::load(v + i);
+                for (int step = 0; step < steps; ++step) gcdStep(uu, vv);
+                uu.store(u + i);
+            }
+#endif
+            for (; i < count; ++i) {
+                for (int step = 0; step < steps; ++step) gcdStep(u[i], v[i]);
+            }
+
+            for (i = 0; i < count; ++i) {
+                auto g = static_cast<NumberType>(u[i] << shift[i]);
+                if (g == 0) continue;
+                if (denominators[i] < 0) g = -g;
+                numerators[i] /= g;
+                denominators[i] /= g;
+            }
+        }
+    }
+
+    /// Записывает значения в out[0..size())
+    void toDouble(double *out) const {
+        const NumberType *numerators = _numerators.data(), *denominators = _denominators.data();
+        for (size_t i = 0; i < size(); ++i) {
+            out[i] = static_cast<double>(numerators[i]) / static_cast<double>(denominators[i]);
+        }
+    }
+
+    [[nodiscard]] std::vector<double> toDouble() const {
+        std::vector<double> result(size());
+        toDouble(result.data());
+        return result;
+    }
+
+private:
+#if defined(__AVX2__)
+    /// Четыре NumberType в регистре AVX2
+    struct NumberLanes {
+        static constexpr size_t width = 4;
+        __m256i value;
+
+        NumberLanes(__m256i value) : value(value) {} // NOLINT(*-explicit-constructor)
+
+        NumberLanes(NumberType number) : value(_mm256_set1_epi64x(number)) {} // NOLINT(*-explicit-constructor)
+
+        static NumberLanes load(const NumberType *from) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(from));
+        }
+
+        void store(NumberType *to) const {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(to), value);
+        }
+
+        friend NumberLanes operator+(NumberLanes x, NumberLanes y) { return _mm256_add_epi64(x.value, y.value); }
+        friend NumberLanes operator-(NumberLanes x, NumberLanes y) { return _mm256_sub_epi64(x.value, y.value); }
+        friend NumberLanes operator-(NumberLanes x) { return _mm256_sub_epi64(_mm256_setzero_si256(), x.value); }
+        friend NumberLanes operator&(NumberLanes x, NumberLanes y) { return _mm256_and_si256(x.value, y.value); }
+        friend NumberLanes operator|(NumberLanes x, NumberLanes y) { return _mm256_or_si256(x.value, y.value); }
+        friend NumberLanes operator^(NumberLanes x, NumberLanes y) { return _mm256_xor_si256(x.value, y.value); }
+        friend NumberLanes operator~(NumberLanes x) { return _mm256_xor_si256(x.value, _mm256_set1_epi64x(-1)); }
+
+        /// Множители должны лежать в [-2^31, 2^31), как на быстром пути apply
+        friend NumberLanes operator*(NumberLanes x, NumberLanes y) { return _mm256_mul_epi32(x.value, y.value); }
+
+        /// Арифметический сдвиг: знак берётся из старшего 32-битного слова каждого элемента
+        friend NumberLanes operator>>(NumberLanes x, int shift) {
+            __m256i sign = _mm256_srai_epi32(_mm256_shuffle_epi32(x.value, _MM_SHUFFLE(3, 3, 1, 1)), 31);
+            return _mm256_or_si256(_mm256_srl_epi64(x.value, _mm_cvtsi32_si128(shift)),
+                                   _mm256_sll_epi64(sign, _mm_cvtsi32_si128(64 - shift)));
+        }
+    };
+#elif defined(__SSE2__) || defined(_M_X64)
+    /// Два NumberType в регистре SSE2
+    struct NumberLanes {
+        static constexpr size_t width = 2;
+        __m128i value;
+
+        NumberLanes(__m128i value) : value(value) {} // NOLINT(*-explicit-constructor)
+
+        NumberLanes(NumberType number) : value(_mm_set1_epi64x(number)) {} // NOLINT(*-explicit-constructor)
+
+        static NumberLanes load(const NumberType *from) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(from));
+        }
+
+        void store(NumberType *to) const {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(to), value);
+        }
+
+        friend NumberLanes operator+(NumberLanes x, NumberLanes y) { return _mm_add_epi64(x.value, y.value); }
+        friend NumberLanes operator-(NumberLanes x, NumberLanes y) { return _mm_sub_epi64(x.value, y.value); }
+        friend NumberLanes operator-(NumberLanes x) { return _mm_sub_epi64(_mm_setzero_si128(), x.value); }
+        friend NumberLanes operator&(NumberLanes x, NumberLanes y) { return _mm_and_si128(x.value, y.value); }
+        friend NumberLanes operator|(NumberLanes x, NumberLanes y) { return _mm_or_si128(x.value, y.value); }
+        friend NumberLanes operator^(NumberLanes x, NumberLanes y) { return _mm_xor_si128(x.value, y.value); }
+        friend NumberLanes operator~(NumberLanes x) { return _mm_xor_si128(x.value, _mm_set1_epi64x(-1)); }
+
+        /// Младшие 64 бита произведения из трёх беззнаковых 32 x 32: lo * lo + ((hi * lo + lo * hi) << 32)
+        friend NumberLanes operator*(NumberLanes x, NumberLanes y) {
+            __m128i low = _mm_mul_epu32(x.value, y.value);
+            __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(x.value, 32), y.value),
+                                          _mm_mul_epu32(x.value, _mm_srli_epi64(y.value, 32)));
+            return _mm_add_epi64(low, _mm_slli_epi64(cross, 32));
+        }
+
+        /// Арифметический сдвиг: знак берётся из старшего 32-битного слова каждого элемента
+        friend NumberLanes operator>>(NumberLanes x, int shift) {
+            __m128i sign = _mm_srai_epi32(_mm_shuffle_epi32(x.value, _MM_SHUFFLE(3, 3, 1, 1)), 31);
+            return _mm_or_si128(_mm_srl_epi64(x.value, _mm_cvtsi32_si128(shift)),
+                                _mm_sll_epi64(sign, _mm_cvtsi32_si128(64 - shift)));
+        }
+    };
+#endif
+
+    /// Шаг бинарного алгоритма на масках без ветвлений: при нечётном v заменяет большее из u, v
+    /// на |u - v|, затем делит v пополам. u остаётся нечётным. Lanes - NumberType или NumberLanes
+    template<typename Lanes>
+    static void gcdStep(Lanes &u, Lanes &v) {
+        Lanes odd = -(v & 1);
+        Lanes delta = v - u;
+        Lanes less = delta >> 63; // v < u: оба меньше 2^63, разность не переполняется
+        Lanes swap = odd & less;
+        Lanes difference = (delta ^ less) - less;
+        u = (v & swap) | (u & ~swap);
+        v = ((difference & odd) | (v & ~odd)) >> 1;
+    }
+
+    static uint64_t magnitude(NumberType value) {
+        return value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+    /// Все ли значения лежат в [-2^31, 2^31): тогда a * d + b * c не переполняет NumberType
+    static bool fitsHalfWord(const std::vector<NumberType> &values) {
+        uint64_t overflow = 0;
+        for (NumberType value: values) {
+            overflow |= (static_cast<uint64_t>(value) + (uint64_t(1) << 31)) >> 32;
+        }
+        return overflow == 0;
+    }
+
+    /// Пакетное ядро kernel на быстром пути, иначе поэлементный Rational с проверкой переполнения
+    template<typename ScalarOp, typename Kernel>
+    RationalArray apply(const RationalArray &other, ScalarOp scalar, Kernel kernel) const {
+        if (size() != other.size()) throw std::invalid_argument("RationalArray sizes differ");
+
+        RationalArray result(size());
+        if (fitsHalfWord(_numerators) && fitsHalfWord(_denominators) &&
+            fitsHalfWord(other._numerators) && fitsHalfWord(other._denominators)) {
+            const NumberType *a = _numerators.data(), *b = _denominators.data();
+            const NumberType *c = other._numerators.data(), *d = other._denominators.data();
+            NumberType *n = result._numerators.data(), *m = result._denominators.data();
+            size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            for (; i + NumberLanes::width <= size(); i += NumberLanes::width) {
+                NumberLanes numerator = 0, denominator = 0;
+                kernel(NumberLanes::load(a + i), NumberLanes::load(b + i), NumberLanes::load(c + i),
+                       NumberLanes::load(d + i), numerator, denominator);
+                numerator.store(n + i);
+                denominator.store(m + i);
+            }
+#endif
+            for (; i < size(); ++i) kernel(a[i], b[i], c[i], d[i], n[i], m[i]);
+        } else {
+            for (size_t i = 0; i < size(); ++i) result.set(i, scalar((*this)[i], other[i]));
+        }
+
+        // Как у Rational: сокращаем, когда значения становятся большими
+        if (!fitsHalfWord(result._numerators) || !fitsHalfWord(result._denominators)) result.reduce();
+        return result;
+    }
+
+    std::vector<NumberType> _numerators, _denominators;
+};
+
+
+/// Плотная матрица над Rational, строки лежат подряд. Исключение ведётся без дробей (алгоритм Барейса)
+/// над целочисленной копией в BigInteger: каждая строка домножается на НОК знаменателей, после чего все
+/// промежуточные элементы - миноры исходной матрицы и делятся на предыдущий ведущий элемент нацело.
+/// Пока миноры помещаются в NumberType, шаг считается в WideNumberType. Определитель или решение случайной
+/// матрицы с элементами от -9 до 9: n = 100 около 0.2 с, n = 200 около 3 с
+class RationalMatrix {
+public:
+    RationalMatrix(size_t rows, size_t columns) : _rows(rows), _columns(columns), _data(rows * columns) {}
+
+    RationalMatrix(std::initializer_list<std::initializer_list<Rational>> rows)
+            : RationalMatrix(rows.size(), rows.size() == 0 ? 0 : rows.begin()->size()) {
+        size_t i = 0;
+        for (const auto &row: rows) {
+            if (row.size() != _columns) throw std::invalid_argument("RationalMatrix rows differ in length");
+            std::copy(row.begin(), row.end(), _data.begin() + i * _columns); // NOLINT(*-narrowing-conversions)
+            ++i;
+        }
+    }
+
+    static RationalMatrix identity(size_t size) {
+        RationalMatrix result(size, size);
+        for (size_t i = 0; i < size; ++i) result(i, i) = 1;
+        return result;
+    }
+
+    [[nodiscard]] size_t rows() const {
+        return _rows;
+    }
+
+    [[nodiscard]] size_t columns() const {
+        return _columns;
+    }
+
+    Rational &operator()(size_t i, size_t j) {
+        return _data[i * _columns + j];
+    }
+
+    const Rational &operator()(size_t i, size_t j) const {
+        return _data[i * _columns + j];
+    }
+
+    bool operator==(const RationalMatrix &other) const = default;
+
+    RationalMatrix operator*(const RationalMatrix &other) const {
+        if (_columns != other._rows) throw std::invalid_argument("RationalMatrix sizes do not match");
+
+        RationalMatrix result(_rows, other._columns);
+        for (size_t i = 0; i < _rows; ++i) {
+            for (size_t k = 0; k < _columns; ++k) {
+                const Rational &factor = (*this)(i, k);
+                if (factor == 0) continue;
+                for (size_t j = 0; j < other._columns; ++j) result(i, j) += factor * other(k, j);
+            }
+        }
+        return result;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const RationalMatrix &matrix) {
+        for (size_t i = 0; i < matrix._rows; ++i) {
+            out << (i == 0 ? "[" : " ");
+            for (size_t j = 0; j < matrix._columns; ++j) out << (j == 0 ? "" : ", ") << matrix(i, j);
+            out << (i + 1 == matrix._rows ? "]" : "\n");
+        }
+        return out;
+    }
+
+    [[nodiscard]] Rational determinant() const {
+        if (_rows != _columns) throw std::invalid_argument("RationalMatrix determinant of a non-square matrix");
+        if (_rows == 0) return 1;
+
+        BigInteger scale = 1;
+        IntegerMatrix work = integerRows(*this, scale);
+        Elimination elimination = eliminate(work, _columns);
+        if (elimination.rank < _rows) return 0;
+
+        Rational result(work(_rows - 1, _columns - 1), scale);
+        return elimination.negative ? -result : result;
+    }
+
+    [[nodiscard]] size_t rank() const {
+        BigInteger scale = 1;
+        IntegerMatrix work = integerRows(*this, scale);
+        return eliminate(work, _columns).rank;
+    }
+
+    /// Решение системы A x = b, для вырожденной матрицы кидает std::domain_error
+    [[nodiscard]] std::vector<Rational> solve(const std::vector<Rational> &b) const {
+        if (b.size() != _rows) throw std::invalid_argument("RationalMatrix right-hand side size differs");
+
+        RationalMatrix right(_rows, 1);
+        for (size_t i = 0; i < _rows; ++i) right(i, 0) = b[i];
+        RationalMatrix x = solve(right);
+
+        std::vector<Rational> result(_columns);
+        for (size_t i = 0; i < _columns; ++i) result[i] = x(i, 0);
+        return result;
+    }
+
+    /// Решение A X = B сразу для всех столбцов B
+    [[nodiscard]] RationalMatrix solve(const RationalMatrix &right) const {
+        if (_rows != _columns) throw std::invalid_argument("RationalMatrix solve with a non-square matrix");
+        if (right._rows != _rows) throw std::invalid_argument("RationalMatrix right-hand side size differs");
+
+        // Строки A домножаются на НОК своих знаменателей, а правая часть - ещё и на НОК знаменателей по
+        // столбцу: так большие знаменатели B не попадают в миноры A. Решение делится на множитель столбца
+        size_t n = _rows, m = right._columns;
+        IntegerMatrix work{n, n + m, std::vector<BigInteger>(n * (n + m))};
+        RationalMatrix scaled = right;
+        for (size_t i = 0; i < n; ++i) {
+            BigInteger multiple = rowMultiple(i);
+            for (size_t j = 0; j < n; ++j) work(i, j) = integerPart((*this)(i, j), multiple);
+            if (multiple == 1) continue;
+            Rational factor(multiple, BigInteger(1));
+            for (size_t k = 0; k < m; ++k) scaled(i, k) *= factor;
+        }
+        std::vector<BigInteger> column_multiples(m);
+        for (size_t k = 0; k < m; ++k) {
+            column_multiples[k] = scaled.columnMultiple(k);
+            for (size_t i = 0; i < n; ++i) work(i, n + k) = integerPart(scaled(i, k), column_multiples[k]);
+        }
+        if (eliminate(work, n).rank < n) throw std::domain_error("RationalMatrix is singular");
+
+        // Обратный ход тоже без дробей: по Крамеру D x - целый вектор, где D = work(n - 1, n - 1) - определитель,
+        // поэтому y_i = (D b_i - sum U_ij y_j) / U_ii делится нацело. В Rational переводим только ответ
+        const BigInteger &determinant = work(n - 1, n - 1);
+        RationalMatrix result(n, m);
+        std::vector<BigInteger> y(n);
+        for (size_t column = 0; column < m; ++column) {
+            BigInteger denominator = determinant * column_multiples[column];
+            for (size_t i = n; i-- > 0;) {
+                BigInteger value = determinant * work(i, n + column);
+                for (size_t j = i + 1; j < n; ++j) {
+                    if (!work(i, j).isZero() && !y[j].isZero()) value -= work(i, j) * y[j];
+                }
+                y[i] = value / work(i, i);
+                result(i, column) = Rational(y[i], denominator);
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] RationalMatrix inverse() const {
+        return solve(identity(_rows));
+    }
+
+private:
+    struct Elimination {
+        size_t rank;
+        bool negative; // нечётное число перестановок строк
+    };
+
+    /// Целочисленная копия для исключения, строки лежат подряд
+    struct IntegerMatrix {
+        size_t rows, columns;
+        std::vector<BigInteger> data;
+
+        BigInteger &operator()(size_t i, size_t j) {
+            return data[i * columns + j];
+        }
+    };
+
+    /// НОК знаменателей строки i
+    [[nodiscard]] BigInteger rowMultiple(size_t i) const {
+        BigInteger multiple = 1;
+        for (size_t j = 0; j < _columns; ++j) {
+            BigInteger denominator = (*this)(i, j).bigDenominator();
+            if (denominator != 1) multiple = multiple / gcd(multiple, denominator) * denominator;
+        }
+        return multiple;
+    }
+
+    /// НОК знаменателей столбца j
+    [[nodiscard]] BigInteger columnMultiple(size_t j) const {
+        BigInteger multiple = 1;
+        for (size_t i = 0; i < _rows; ++i) {
+            BigInteger denominator = (*this)(i, j).bigDenominator();
+            if (denominator != 1) multiple = multiple / gcd(multiple, denominator) * denominator;
+        }
+        return multiple;
+    }
+
+    /// value * multiple, где multiple делится на знаменатель value
+    static BigInteger integerPart(const Rational &value, const BigInteger &multiple) {
+        if (multiple == 1) return value.bigNumerator();
+        return value.bigNumerator() * (multiple / value.bigDenominator());
+    }
+
+    /// Копия matrix, в которой каждая строка домножена на НОК знаменателей своих элементов;
+    /// scale домножается на произведение этих множителей
+    static IntegerMatrix integerRows(const RationalMatrix &matrix, BigInteger &scale) {
+        IntegerMatrix result{matrix._rows, matrix._columns, std::vector<BigInteger>(matrix._data.size())};
+        for (size_t i = 0; i < matrix._rows; ++i) {
+            BigInteger multiple = matrix.rowMultiple(i);
+            for (size_t j = 0; j < matrix._columns; ++j) result(i, j) = integerPart(matrix(i, j), multiple);
+            if (multiple != 1) scale *= multiple;
+        }
+        return result;
+    }
+
+    /// Быстрый путь держит элементы меньше 2^62 по модулю: тогда a d - b c не переполняет WideNumberType
+    static constexpr WideNumberType fastLimit = WideNumberType(1) << 62;
+
+    /// Шаг Барейса value = (leading value - factor pivot) / previous, деление нацело.
+    /// false, если результат вышел за быстрый путь
+    static bool bareissStep(NumberType &value, NumberType leading, NumberType factor, NumberType pivot,
+                            NumberType previous) {
+        WideNumberType result = WideNumberType(leading) * value - WideNumberType(factor) * pivot;
+        if (previous != 1) result /= previous;
+        if (result <= -fastLimit || result >= fastLimit) return false;
+        value = static_cast<NumberType>(result);
+        return true;
+    }
+
+    static bool bareissStep(BigInteger &value, const BigInteger &leading, const BigInteger &factor,
+                            const BigInteger &pivot, const BigInteger &previous) {
+        value *= leading;
+        if (!factor.isZero() && !pivot.isZero()) value -= factor * pivot;
+        if (previous != 1) value /= previous;
+        return true;
+    }
+
+    /// Приводит целочисленную матрицу к ступенчатому виду по первым pivot_columns столбцам методом Барейса.
+    /// Строки после ранга обнуляются, у полной по рангу квадратной части последний ведущий элемент - определитель.
+    /// Сначала пробует NumberType; если минор не поместился, начинает заново в BigInteger
+    static Elimination eliminate(IntegerMatrix &matrix, size_t pivot_columns) {
+        bool small = std::all_of(matrix.data.begin(), matrix.data.end(), [](const BigInteger &value) {
+            return value.fitsNumberType() && value.toNumberType() > -fastLimit && value.toNumberType() < fastLimit;
+        });
+        if (small) {
+            std::vector<NumberType> values(matrix.data.size());
+            std::transform(matrix.data.begin(), matrix.data.end(), values.begin(),
+                           [](const BigInteger &value) { return value.toNumberType(); });
+            if (auto result = bareiss(values, matrix.rows, matrix.columns, pivot_columns)) {
+                std::copy(values.begin(), values.end(), matrix.data.begin());
+                return *result;
+            }
+        }
+        return *bareiss(matrix.data, matrix.rows, matrix.columns, pivot_columns);
+    }
+
+    template<class Value>
+    static std::optional<Elimination> bareiss(std::vector<Value> &data, size_t rows, size_t columns,
+                                              size_t pivot_columns) {
+        const size_t tile = 64; // столбцы обрабатываются полосами, чтобы ведущая строка оставалась в кеше
+        Elimination result{0, false};
+        Value previous = 1;
+
+        for (size_t column = 0; column < pivot_columns && result.rank < rows; ++column) {
+            size_t r = result.rank;
+            size_t pivot = r;
+            while (pivot < rows && data[pivot * columns + column] == 0) ++pivot;
+            if (pivot == rows) continue;
+            if (pivot != r) {
+                std::swap_ranges(data.begin() + pivot * columns, data.begin() + (pivot + 1) * columns, // NOLINT(*-narrowing-conversions)
+                                 data.begin() + r * columns); // NOLINT(*-narrowing-conversions)
+                result.negative = !result.negative;
+            }
+
+            const Value leading = data[r * columns + column];
+            for (size_t tile_begin = column + 1; tile_begin < columns; tile_begin += tile) {
+                size_t tile_end = std::min(columns, tile_begin + tile);
+                for (size_t i = r + 1; i < rows; ++i) {
+                    const Value &factor = data[i * columns + column];
+                    for (size_t j = tile_begin; j < tile_end; ++j) {
+                        if (!bareissStep(data[i * columns + j], leading, factor, data[r * columns + j], previous)) {
+                            return std::nullopt;
+                        }
+                    }
+                }
+            }
+            for (size_t i = r + 1; i < rows; ++i) data[i * columns + column] = 0;
+
+            previous = leading;
+            ++result.rank;
+        }
+
+        return result;
+    }
+
+    size_t _rows, _columns;
+    std::vector<Rational> _data;
+};
+
+/// Запись "p/q" в [first, last) по соглашениям std::to_chars. Знак всегда переносится в числитель,
+/// несокращённое значение выводится как есть. Для маленьких значений не выделяет память
+template<Normalization Policy>
+std::to_chars_result toChars(char *first, char *last, const BasicRational<Policy> &value) {
+    if (!value.isSmall()) {
+        BigInteger numerator = value.bigNumerator(), denominator = value.bigDenominator();
+        if (denominator.isNegative()) {
+            numerator = -numerator;
+            denominator = -denominator;
+        }
+        auto result = toChars(first, last, numerator);
+        if (result.ec != std::errc()) return result;
+        if (result.ptr == last) return {last, std::errc::value_too_large};
+        *result.ptr = '/';
+        return toChars(result.ptr + 1, last, denominator);
+    }
+
+    NumberType numerator = value.numerator(), denominator = value.denominator();
+    bool negative = (numerator < 0) != (denominator < 0) && numerator != 0;
+    // модули через беззнаковое отрицание: -INT64_MIN не помещается в NumberType
+    auto numerator_magnitude = numerator < 0 ? 0 - static_cast<uint64_t>(numerator) : static_cast<uint64_t>(numerator);
+    auto denominator_magnitude =
+            denominator < 0 ? 0 - static_cast<uint64_t>(denominator) : static_cast<uint64_t>(denominator);
+
+    if (negative) {
+        if (first == last) return {last, std::errc::value_too_large};
+        *first++ = '-';
+    }
+    auto result = std::to_chars(first, last, numerator_magnitude);
+    if (result.ec != std::errc()) return result;
+    if (result.ptr == last) return {last, std::errc::value_too_large};
+    *result.ptr = '/';
+    return std::to_chars(result.ptr + 1, last, denominator_magnitude);
+}
+
+/// Десятичная запись с precision знаками после точки, округление половины от нуля
+template<Normalization Policy>
+std::to_chars_result toChars(char *first, char *last, const BasicRational<Policy> &value, int precision) {
+    if (precision < 0) return {last, std::errc::invalid_argument};
+    char *start = first;
+
+    if (!value.isSmall()) {
+        BigInteger numerator = abs(value.bigNumerator()), denominator = abs(value.bigDenominator());
+        bool negative = value.bigNumerator().isNegative() != value.bigDenominator().isNegative();
+        auto [quotient, remainder] = BigInteger::divMod(numerator * BinaryPower(BigInteger(10), precision),
+                                                        denominator);
+        if (remainder + remainder >= denominator) quotient += 1;
+        if (quotient.isZero()) negative = false;
+
+        if (negative) {
+            if (first == last) return {last, std::errc::value_too_large};
+            *first++ = '-';
+        }
+        auto result = toChars(first, last, quotient);
+        if (result.ec != std::errc()) return result;
+
+        // Дополняем нулями до precision + 1 цифр и вставляем точку
+        auto digits = static_cast<size_t>(result.ptr - first), need = static_cast<size_t>(precision) + 1;
+        size_t length = std::max(digits, need) + (precision > 0 ? 1 : 0);
+        if (static_cast<size_t>(last - first) < length) return {last, std::errc::value_too_large};
+        if (digits < need) {
+            std::memmove(first + (need - digits), first, digits);
+            std::fill_n(first, need - digits, '0');
+            digits = need;
+        }
+        if (precision > 0) {
+            std::memmove(first + digits - precision + 1, first + digits - precision, static_cast<size_t>(precision));
+            first[digits - precision] = '.';
+        }
+        return {first + length, std::errc()};
+    }
+
+    NumberType numerator = value.numerator(), denominator = value.denominator();
+    bool negative = (numerator < 0) != (denominator < 0) && numerator != 0;
+    auto numerator_magnitude = numerator < 0 ? 0 - static_cast<uint64_t>(numerator) : static_cast<uint64_t>(numerator);
+    auto denominator_magnitude =
+            denominator < 0 ? 0 - static_cast<uint64_t>(denominator) : static_cast<uint64_t>(denominator);
+
+    if (negative) {
+        if (first == last) return {last, std::errc::value_too_large};
+        *first++ = '-';
+    }
+    char *integer_begin = first;
+    auto result = std::to_chars(first, last, numerator_magnitude / denominator_magnitude);
+    if (result.ec != std::errc()) return result;
+    char *end = result.ptr;
+    if (last - end < precision + (precision > 0 ? 1 : 0)) return {last, std::errc::value_too_large};
+
+    // Дробная часть делением столбиком
+    uint64_t remainder = numerator_magnitude % denominator_magnitude;
+    if (precision > 0) *end++ = '.';
+    for (int i = 0; i < precision; ++i) {
+        auto current = static_cast<unsigned __int128>(remainder) * 10;
+        *end++ = static_cast<char>('0' + static_cast<int>(current / denominator_magnitude));
+        remainder = static_cast<uint64_t>(current % denominator_magnitude);
+    }
+
+    if (remainder >= denominator_magnitude - remainder) {
+        // перенос единицы справа налево
+        char *digit = end;
+        while (digit != integer_begin) {
+            --digit;
+            if (*digit == '.') continue;
+            if (*digit != '9') {
+                ++*digit;
+                break;
+            }
+            *digit = '0';
+            if (digit == integer_begin) {
+                if (end == last) return {last, std::errc::value_too_large};
+                std::memmove(integer_begin + 1, integer_begin, static_cast<size_t>(end - integer_begin));
+                *integer_begin = '1';
+                ++end;
+                break;
+            }
+        }
+    }
+
+    // "-0.000" печатаем без знака
+    if (negative && std::all_of(integer_begin, end, [](char c) { return c == '0' || c == '.'; })) {
+        std::memmove(start, integer_begin, static_cast<size_t>(end - integer_begin));
+        end -= integer_begin - start;
+    }
+    return {end, std::errc()};
+}
+
+/// Разбор "p/q", целого или десятичной записи с необязательной экспонентой ("-1.25e-3") по соглашениям
+/// std::from_chars: при ошибке value не меняется. Пока числа помещаются в NumberType, память не выделяется
+template<Normalization Policy>
+std::from_chars_result fromChars(const char *first, const char *last, BasicRational<Policy> &value) {
+    // Ограничение на экспоненту, чтобы "1e999999999" не строил гигантских степеней десятки
+    constexpr int max_exponent = 100000;
+    const char *p = first;
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    // Мантисса: цифры, затем необязательная дробная часть
+    const char *mantissa_begin = p;
+    uint64_t mantissa = 0;
+    int digits = 0, fraction_digits = 0;
+    bool fits = true;
+    for (; p != last && is_digit(*p); ++p, ++digits) {
+        fits = fits && !__builtin_mul_overflow(mantissa, 10, &mantissa) &&
+               !__builtin_add_overflow(mantissa, static_cast<uint64_t>(*p - '0'), &mantissa);
+    }
+
+    if (digits > 0 && p != last && *p == '/') {
+        const char *denominator_begin = ++p;
+        uint64_t denominator = 0;
+        bool denominator_fits = true;
+        for (; p != last && is_digit(*p); ++p) {
+            denominator_fits = denominator_fits && !__builtin_mul_overflow(denominator, 10, &denominator) &&
+                               !__builtin_add_overflow(denominator, static_cast<uint64_t>(*p - '0'), &denominator);
+        }
+        if (p == denominator_begin) return {first, std::errc::invalid_argument};
+
+        const auto limit = static_cast<uint64_t>(std::numeric_limits<NumberType>::max());
+        if (fits && denominator_fits && mantissa <= limit && denominator <= limit) {
+            if (denominator == 0) return {first, std::errc::invalid_argument};
+            auto numerator = static_cast<NumberType>(mantissa);
+            value = BasicRational<Policy>(negative ? -numerator : numerator, static_cast<NumberType>(denominator));
+            return {p, std::errc()};
+        }
+        BigInteger numerator = BigInteger::fromDigits(mantissa_begin, denominator_begin - 1);
+        BigInteger big_denominator = BigInteger::fromDigits(denominator_begin, p);
+        if (big_denominator.isZero()) return {first, std::errc::invalid_argument};
+        value = BasicRational<Policy>(negative ? -numerator : numerator, big_denominator);
+        return {p, std::errc()};
+    }
+
+    if (p != last && *p == '.') {
+        for (++p; p != last && is_digit(*p); ++p, ++digits, ++fraction_digits) {
+            fits = fits && !__builtin_mul_overflow(mantissa, 10, &mantissa) &&
+                   !__builtin_add_overflow(mantissa, static_cast<uint64_t>(*p - '0'), &mantissa);
+        }
+    }
+    if (digits == 0) return {first, std::errc::invalid_argument};
+    const char *mantissa_end = p;
+
+    int exponent = 0;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char *exponent_begin = p++;
+        bool exponent_negative = false;
+        if (p != last && (*p == '-' || *p == '+')) exponent_negative = *p++ == '-';
+        if (p == last || !is_digit(*p)) {
+            p = exponent_begin; // "1e" - разобрано только "1", как у std::from_chars
+        } else {
+            for (; p != last && is_digit(*p); ++p) {
+                if (exponent > max_exponent) return {first, std::errc::result_out_of_range};
+                exponent = exponent * 10 + (*p - '0');
+            }
+            if (exponent_negative) exponent = -exponent;
+        }
+    }
+    exponent -= fraction_digits;
+    if (exponent > max_exponent || exponent < -max_exponent) return {first, std::errc::result_out_of_range};
+
+    // Быстрый путь: 10^|exponent| и результат помещаются в NumberType
+    const auto limit = static_cast<uint64_t>(std::numeric_limits<NumberType>::max());
+    if (fits && mantissa <= limit && exponent > -19 && exponent < 19) {
+        uint64_t power = 1;
+        for (int i = 0; i < std::abs(exponent); ++i) power *= 10;
+        uint64_t numerator = mantissa, denominator = 1;
+        bool small = true;
+        if (exponent >= 0) {
+            small = !__builtin_mul_overflow(mantissa, power, &numerator) && numerator <= limit;
+        } else {
+            denominator = power;
+        }
+        if (small) {
+            auto signed_numerator = static_cast<NumberType>(numerator);
+            value = BasicRational<Policy>(negative ? -signed_numerator : signed_numerator,
+                                          static_cast<NumberType>(denominator));
+            return {p, std::errc()};
+        }
+    }
+
+    BigInteger numerator = BigInteger::fromDigits(mantissa_begin, mantissa_end);
+    BigInteger denominator = 1;
+    if (exponent >= 0) {
+        numerator *= BinaryPower(BigInteger(10), static_cast<uint64_t>(exponent));
+    } else {
+        denominator = BinaryPower(BigInteger(10), static_cast<uint64_t>(-exponent));
+    }
+    value = BasicRational<Policy>(negative ? -numerator : numerator, denominator);
+    return {p, std::errc()};
+}
+
+/// Записывает значения в файл по одному в строке в формате toChars. Строки собираются в общем буфере
+/// и уходят в файл блоками, так что на каждое маленькое значение не приходится ни выделений, ни работы потока
+template<std::ranges::input_range Range>
+void writeRationals(const std::filesystem::path &path, const Range &values) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("cannot open " + path.string() + " for writing");
+
+    std::vector<char> buffer(1 << 16);
+    char *position = buffer.data(), *end = buffer.data() + buffer.size();
+    auto flush = [&] {
+        out.write(buffer.data(), position - buffer.data());
+        position = buffer.data();
+    };
+
+    for (const auto &value: values) {
+        auto result = toChars(position, end - 1, value);
+        if (result.ec != std::errc()) {
+            flush();
+            result = toChars(position, end - 1, value);
+        }
+        if (result.ec != std::errc()) {
+            // Длинное значение не влезает даже в пустой буфер
+            auto length = (value.bigNumerator().bitLength() + value.bigDenominator().bitLength()) / 3 + 4;
+            std::vector<char> large(length);
+            result = toChars(large.data(), large.data() + large.size() - 1, value);
+            *result.ptr++ = '\n';
+            out.write(large.data(), result.ptr - large.data());
+            continue;
+        }
+        *result.ptr = '\n';
+        position = result.ptr + 1;
+    }
+    flush();
+    if (!out) throw std::runtime_error("cannot write " + path.string());
+}
+
+/// Читает файл со значениями по одному в строке (пустые строки и '\r' перед '\n' пропускаются).
+/// Файл читается блоками, строки разбираются прямо в буфере; при ошибке кидает std::runtime_error с номером строки
+inline std::vector<Rational> readRationals(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path.string() + " for reading");
+
+    std::vector<Rational> result;
+    std::vector<char> buffer(1 << 16);
+    size_t filled = 0, line_number = 0;
+    bool eof = false;
+
+    while (!eof || filled > 0) {
+        if (!eof) {
+            if (filled == buffer.size()) buffer.resize(buffer.size() * 2); // строка длиннее буфера
+            in.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+            filled += static_cast<size_t>(in.gcount());
+            eof = !in;
+        }
+
+        const char *begin = buffer.data(), *end = buffer.data() + filled;
+        while (begin != end) {
+            const char *newline = std::find(begin, end, '\n');
+            if (newline == end && !eof) break; // неполная строка, дочитаем
+
+            ++line_number;
+            const char *line_end = newline;
+            if (line_end != begin && line_end[-1] == '\r') --line_end;
+            if (line_end != begin) {
+                Rational value;
+                auto parsed = fromChars(begin, line_end, value);
+                if (parsed.ec != std::errc() || parsed.ptr != line_end) {
+                    throw std::runtime_error(path.string() + ":" + std::to_string(line_number) + ": invalid rational");
+                }
+                result.push_back(std::move(value));
+            }
+            begin = newline == end ? end : newline + 1;
+        }
+
+        filled = static_cast<size_t>(end - begin);
+        std::memmove(buffer.data(), begin, filled);
+        if (eof && filled == 0) break;
+    }
+    return result;
+}
@@ -1,191 +1,11 @@
 #include <iostream>
-#include <cmath>
 #include <cassert>
 #include <sstream>
 #include <vector>
+#include <string>
 
-using NumberType = int64_t;
+#include "rational_numbers.h"
 
-template<typename T>
-T gcd(T a, T b) {
-    int t;
-    while (b != 0) {
-        t = b;
-        b = a % b;
-        a = t;
-    }
-
-    return a;
-}
-
-
-template<typename T>
-T BinaryPower(T b, uint64_t e) {
-    T v = 1;
-    while (e != 0) {
-        if ((e & 1) != 0) {
-            v *= b;
-        }
-        b *= b;
-        e >>= 1;
-    }
-    return v;
-}
-
-class Rational {
-public:
-
-    Rational(NumberType m, NumberType n) : _numerator(m), _denominator(n) {
-//        reduce();
-    }
-
-    // Фикс бед компиляции
-    Rational(int m, int n) : _numerator(m), _denominator(n) {}
-
-    Rational(NumberType n) : _numerator(n), _denominator(1) {}
-
-    explicit Rational(double number, double precision) {
-        _numerator = static_cast<NumberType>(number * precision);
-        _denominator = static_cast<NumberType>(precision);
-        reduce();
-    }
-
-
-    Rational() : _numerator(0), _denominator(1) {}
-
-    friend std::ostream &operator<<(std::ostream &out, const Rational &r) {
-        out << r._numerator << "/" << r._denominator;
-        return out;
-    }
-
-    Rational operator-() const {
-        return {-_numerator, _denominator};
-    }
-
-    // prefix increment
-    Rational &operator++() {
-        _numerator += _denominator;
-        return *this;
-    }
-
-    // postfix increment
-    Rational operator++(int) {
-        Rational old = *this; // copy
-        operator++();
-        return old;
-    }
-
-    // prefix decrement
-    Rational &operator--() {
-        _numerator -= _denominator;
-        return *this;
-    }
-
-    // postfix decrement
-    Rational operator--(int) {
-        Rational result = *this; // copy
-        --(*this);
-        return result;
-    }
-
-    Rational operator+(const Rational &other) const {
-        return {_numerator * other._denominator + _denominator * other._numerator, _denominator * other._denominator};
-    }
-
-    Rational operator-(const Rational &other) const {
-        return {_numerator * other._denominator - _denominator * other._numerator, _denominator * other._denominator};
-    }
-
-    Rational operator*(const Rational &other) const {
-        return {_numerator * other._numerator, _denominator * other._denominator};
-    }
-
-
-    template<typename T>
-    friend Rational operator*(const T factor, const Rational &other) {
-        return {other._numerator * factor, other._denominator};
-    }
-
-    Rational operator/(const Rational &other) const {
-        return {_numerator * other._denominator, _denominator * other._numerator};
-    }
-
-    Rational operator+=(const Rational &other) {
-        _numerator = _numerator * other._denominator + _denominator * other._numerator;
-        _denominator = _denominator * other._denominator;
-        return *this;
-    }
-
-    Rational operator-=(const Rational &other) {
-        _numerator = _numerator * other._denominator - _denominator * other._numerator;
-        _denominator = _denominator * other._denominator;
-        return *this;
-    }
-
-    Rational operator*=(const Rational &other) {
-        _numerator = _numerator * other._numerator;
-        _denominator = _denominator * other._denominator;
-        return *this;
-    }
-
-
-    Rational operator/=(const Rational &other) {
-
-        if (this == &other) {
-            _numerator = 1;
-            _denominator = 1;
-            return *this;
-        }
-
-        _numerator = _numerator * other._denominator;
-        _denominator = _denominator * other._numerator;
-        return *this;
-    }
-
-
-    friend Rational intPow(Rational r, unsigned long long power) {
-        return {
-                static_cast<NumberType>(BinaryPower(r._numerator, power)),
-                static_cast<NumberType>(BinaryPower(r._denominator, power)),
-        };
-    }
-
-    friend Rational pow(Rational r, double power) {
-        return {static_cast<NumberType>(pow(r._numerator, power)),
-                static_cast<NumberType>( pow(r._denominator, power))};
-    }
-
-
-    explicit operator double() const {
-        return static_cast<double >(_numerator) / static_cast<double >(_denominator);
-    }
-
-
-    [[nodiscard]] NumberType numerator() const {
-        return _numerator;
-    }
-
-    [[nodiscard]] NumberType denominator() const {
-        return _denominator;
-    }
-
-
-    /// Приводит к несократимому виду
-    void reduce() {
-        NumberType t = gcd(_numerator, _denominator);
-        _numerator /= t;
-        _denominator /= t;
-
-
-        if (_denominator < static_cast<NumberType>(0)) {
-            _denominator = -_denominator;
-            _numerator = -_numerator;
-        }
-    }
-
-private:
-    NumberType _numerator, _denominator;
-};
 
 void test_rational_number() {
     Rational r, q, p;
@@ -373,8 +193,9 @@ void test_rational_number() {
     std::cout << res;
 }
 
-template<typename T>
-void printVector(const std::vector<T> &vec, const std::string &sep = ", ", const std::string &term = "\n") {
+/// Печатает любой контейнер с size() и operator[], например std::vector или RationalArray
+template<typename Container>
+void printVector(const Container &vec, const std::string &sep = ", ", const std::string &term = "\n") {
 
     std::cout << "{";
 
@@ -395,30 +216,437 @@ void printVector(const std::vector<T> &vec, const std::string &sep = ", ", const
 }
 
 
-/// Возвращает первых n чисел Бернулли, начиная с первого
-std::vector<Rational> getBernoulliNumbers(const int n) {
-    std::vector<Rational> numbers(n);
-    std::vector<Rational> buffer(n + 1);
-    buffer[0] = 1;// Делаем нулевую итерация цикла
 
-    for (int i = 1; i <= n; ++i) {
+
+void test_big_rational() {
+    Rational r, q;
+    std::stringstream s;
+
+    // переполнение числителя
+    NumberType one = 1, big = 3037000499LL * 2, four = 4000000000LL, three = 3000000001LL;
+    r = Rational(std::numeric_limits<NumberType>::max(), one);
+    q = r + Rational(1);
+    assert(!q.isSmall());
+    s << q;
+    assert(s.str() == "9223372036854775808/1");
+    assert(q - Rational(1) == r);
+    assert((q - Rational(1)).isSmall());
+
+    // переполнение знаменателя с последующим сокращением
+    r = Rational(one, big);
+    q = r * r * r;
+    assert(!q.isSmall());
+    q = q / (r * r);
+    assert(q.isSmall());
+    assert(q == r);
+
+    // произведение, которое помещается после сокращения
+    r = Rational(four, three);
+    q = r * Rational(three, four);
+    assert(q.isSmall());
+    assert(q == Rational(1));
+
+    // длинное деление
+    BigInteger a = BigInteger(1234567890123456789LL) * BigInteger(987654321987654321LL) + BigInteger(42);
+    auto [quotient, remainder] = BigInteger::divMod(a, BigInteger(987654321987654321LL));
+    assert(quotient == BigInteger(1234567890123456789LL));
+    assert(remainder == BigInteger(42));
+
+    assert(fabs(static_cast<double>(intPow(Rational(3, 2), 200)) - pow(1.5, 200)) / pow(1.5, 200) < 1e-12);
+    assert(static_cast<double>(intPow(Rational(1, 3), 300)) > 0.0);
+}
+
+void test_normalization() {
+    // gcd
+    assert(gcd(0, 5) == 5);
+    assert(gcd(-12, 18) == 6);
+    assert(gcd(NumberType(1) << 62, NumberType(3) << 40) == NumberType(1) << 40);
+    assert(gcd(static_cast<WideNumberType>(1) << 100, static_cast<WideNumberType>(6) << 70) ==
+           static_cast<WideNumberType>(1) << 71);
+
+    // Eager сокращает всегда
+    BasicRational<Normalization::Eager> e = {14, -21};
+    assert(e.numerator() == -2);
+    assert(e.denominator() == 3);
+    e = e + BasicRational<Normalization::Eager>(5, 3);
+    assert(e.numerator() == 1);
+    assert(e.denominator() == 1);
+
+    // Manual не сокращает никогда
+    BasicRational<Normalization::Manual> m = {14, 21};
+    assert(m.numerator() == 14);
+    m = m + m;
+    assert(m.numerator() == 14 * 21 * 2);
+
+    // Lazy сокращает только большие значения
+    NumberType big = NumberType(3) << 40;
+    Rational r = {14, 21};
+    assert(r.numerator() == 14);
+    r = Rational(big, 2 * big);
+    assert(r.numerator() == 1);
+    assert(r.denominator() == 2);
+
+    // перекрёстное сокращение при умножении и делении
+    m = BasicRational<Normalization::Manual>(4, 9) * BasicRational<Normalization::Manual>(3, 8);
+    assert(m.numerator() == 1);
+    assert(m.denominator() == 6);
+    m = BasicRational<Normalization::Manual>(4, 9) / BasicRational<Normalization::Manual>(8, 3);
+    assert(m.numerator() == 1);
+    assert(m.denominator() == 6);
+
+    // смена политики
+    r = Rational(BasicRational<Normalization::Manual>(14, 21));
+    assert(r == Rational(2, 3));
+}
+
+void test_bernoulli() {
+    // Сверяем с рекурсией Акиямы–Танигавы в точной арифметике
+    const int n = 120;
+    std::vector<Rational> buffer(n + 1);
+    for (int i = 0; i <= n; ++i) {
         buffer[i] = {1, i + 1};
         for (int j = i; j > 0; --j) {
             buffer[j - 1] = j * (buffer[j - 1] - buffer[j]);
-            buffer[j - 1].reduce();
         }
+        assert(BernoulliTable::get(i) == buffer[0]);
+    }
+
+    // Повторный запрос меньшего n не пересчитывает таблицу
+    const Rational &b_100 = BernoulliTable::get(100);
+    BernoulliTable::reserve(50);
+    assert(&BernoulliTable::get(100) == &b_100);
 
-        numbers[i - 1] = buffer[0];
+    auto numbers = getBernoulliNumbers(500);
+    assert(numbers[2].numerator() == 0);
+    assert(numbers[499].bigDenominator() == BigInteger(NumberType(2) * 3 * 5 * 11 * 101 * 251));
+}
+
+void test_rational_array() {
+    std::vector<Rational> lhs, rhs;
+    for (int i = 1; i <= 1000; ++i) {
+        lhs.emplace_back(i, i + 7);
+        rhs.emplace_back(-3 * i, 2 * i + 1);
+    }
+    RationalArray a(lhs), b(rhs);
+
+    RationalArray sum = a + b, difference = a - b, product = a * b, quotient = a / b;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        assert(sum[i] == lhs[i] + rhs[i]);
+        assert(difference[i] == lhs[i] - rhs[i]);
+        assert(product[i] == lhs[i] * rhs[i]);
+        assert(quotient[i] == lhs[i] / rhs[i]);
+        assert(quotient.denominators()[i] > 0); // делитель отрицательный
+    }
+    RationalArray half(std::vector<Rational>{{1, 2}}), minus_third(std::vector<Rational>{{-1, 3}});
+    RationalArray ratio = half / minus_third;
+    assert(ratio.numerators()[0] == -3 && ratio.denominators()[0] == 2);
+
+    // пакетное сокращение
+    product.reduce();
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        Rational expected = lhs[i] * rhs[i];
+        expected.reduce();
+        assert(product[i].numerator() == expected.numerator());
+        assert(product[i].denominator() == expected.denominator());
     }
 
-    return numbers;
+    // медленный путь с большими значениями
+    NumberType one = 1, big = one << 40;
+    RationalArray c(std::vector<Rational>{{big, 3 * big}, {5 * one, -big}});
+    RationalArray d(std::vector<Rational>{{1, 3}, {one, big}});
+    RationalArray e = c + d;
+    assert(e[0] == Rational(2, 3));
+    assert(e[1] == Rational(-4 * one, big));
+    assert(e[1].denominator() > 0);
+
+    // предусловие: результат обязан помещаться в NumberType
+    NumberType huge = one << 62;
+    RationalArray f(std::vector<Rational>{{huge, one}, {one, 2 * one}});
+    bool overflow = false;
+    try {
+        auto unused = f + f;
+    } catch (const std::overflow_error &) {
+        overflow = true;
+    }
+    assert(overflow);
+
+    std::vector<double> values = sum.toDouble();
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        assert(fabs(values[i] - static_cast<double>(lhs[i] + rhs[i])) < 1e-12);
+    }
+
+    printVector(RationalArray(std::vector<Rational>{{1, 2}, {3, 4}}));
+}
+
+void test_from_double() {
+    static_assert(Rational::fromDouble(0.375) == Rational(3, 8));
+    static_assert(Rational::approximate(3.141592653589793, 1000) == Rational(355, 113));
+
+    Rational r = Rational::fromDouble(0.1);
+    assert(r.numerator() == 3602879701896397);
+    assert(r.denominator() == NumberType(1) << 55);
+    assert(Rational::fromDouble(-3.0) == Rational(-3));
+    assert(Rational::fromDouble(0.0) == Rational(0));
+    assert(Rational::fromDouble(1e300).bigNumerator() > BigInteger::powerOfTwo(996));
+    assert(Rational::fromDouble(5e-324).bigDenominator() == BigInteger::powerOfTwo(1074));
+
+    for (double x: {0.1, -2.75, 1e300, 1e-300, 5e-324, 123456789.123, -4.9406564584124654e-320, 1.0 / 3.0}) {
+        assert(static_cast<double>(Rational::fromDouble(x)) == x);
+    }
+
+    assert(Rational::approximate(std::numbers::pi, 100) == Rational(311, 99));
+    assert(Rational::approximate(-std::numbers::pi, 1000) == Rational(-355, 113));
+    assert(Rational::approximate(0.1, 1000000) == Rational(1, 10));
+    assert(Rational::approximate(1e-30, 1000) == Rational(0));
+    assert(Rational::approximate(1e-300, 1000) == Rational(0));
+    assert(Rational::approximate(0.999, 10) == Rational(1));
+    assert(Rational::approximate(1.234824, 10000000) == Rational(1.234824, 1e7));
+    assert(Rational::approximate(1e30, 5) == Rational::fromDouble(1e30));
+}
+
+void test_expression_templates() {
+    Rational a = {3, 4}, b = {5, 6}, c = {-7, 10};
+
+    Rational r = lazy(a) + b * c;
+    assert(r == a + b * c);
+    assert(r.numerator() == 1);
+    assert(r.denominator() == 6);
+
+    r = 3 * (lazy(a) - b) / c + 2;
+    assert(r == Rational(3) * (a - b) / c + Rational(2));
+    assert(r.numerator() == 33);
+    assert(r.denominator() == 14);
+
+    r = -(lazy(a) * a) - a;
+    assert(r == Rational(-21, 16));
+
+    // выражения с Rational в длинном представлении и с переполнением внутри
+    NumberType one = 1, big = std::numeric_limits<NumberType>::max();
+    Rational huge = Rational(big) * Rational(big);
+    r = lazy(huge) / huge + 1;
+    assert(r == Rational(2));
+    r = lazy(Rational(big, one)) * big * big / big / big;
+    assert(r == Rational(big));
+    assert(r.isSmall());
+
+    static_assert(Rational(lazy(Rational(1, 2)) + Rational(1, 3) * 2) == Rational(7, 6));
+}
+
+void test_series() {
+    // гармоническое число сверяем с последовательным сложением
+    const int n = 2000;
+    auto harmonic_terms = std::views::iota(1, n + 1) | std::views::transform([](int i) { return Rational(1, i); });
+    Rational serial;
+    for (int i = 1; i <= n; ++i) serial += Rational(1, i);
+    Rational harmonic = sum(harmonic_terms);
+    assert(harmonic == serial);
+    assert(harmonic.bigDenominator() == serial.bigDenominator());
+
+    // пример из test_rational_number: 1/4 + 1/8 + ... + 1/2^19
+    std::vector<Rational> powers;
+    for (int i = 2; i < 20; ++i) powers.emplace_back(1, BinaryPower(2, i));
+    Rational geometric = sum(powers);
+    assert(geometric.numerator() == (1 << 18) - 1);
+    assert(geometric.denominator() == 1 << 19);
+
+    // произведение (1 - 1/k^2) для k = 2..n равно (n + 1) / 2n
+    auto factors = std::views::iota(2, n + 1) | std::views::transform([](int k) {
+        return Rational(1) - Rational(1, k * k);
+    });
+    assert(product(factors) == Rational(n + 1, 2 * n));
+
+    assert(sum(std::vector<Rational>()) == Rational(0));
+    assert(product(std::vector<Rational>()) == Rational(1));
+}
+
+void test_matrix() {
+    // определитель и обратная к матрице Гильберта
+    const size_t n = 6;
+    RationalMatrix hilbert(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) hilbert(i, j) = {NumberType(1), static_cast<NumberType>(i + j + 1)};
+    }
+    RationalMatrix h4(4, 4);
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 4; ++j) h4(i, j) = hilbert(i, j);
+    }
+    assert(h4.determinant() == Rational(1, 6048000));
+    assert(hilbert.determinant() == Rational(NumberType(1), NumberType(186313420339200000)));
+
+    RationalMatrix inverse = hilbert.inverse();
+    assert(hilbert * inverse == RationalMatrix::identity(n));
+    assert(inverse(0, 0) == Rational(36));
+    assert(inverse(n - 1, n - 1) == Rational(NumberType(698544))); // (2n - 1) C(2n - 2, n - 1)^2
+
+    // система
+    RationalMatrix a = {
+            {2, 1,  -1},
+            {-3, -1, 2},
+            {-2, 1,  2},
+    };
+    std::vector<Rational> x = a.solve({8, -11, -3});
+    assert(x == (std::vector<Rational>{2, 3, -1}));
+
+    // ранг и перестановка строк
+    RationalMatrix degenerate = {
+            {0,                   0, 1},
+            {Rational(1, 2),      1, 3},
+            {Rational(3, 2),      3, 9},
+    };
+    assert(degenerate.rank() == 2);
+    assert(degenerate.determinant() == 0);
+    bool thrown = false;
+    try {
+        auto unused = degenerate.inverse();
+    } catch (const std::domain_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    RationalMatrix swapped = {
+            {0, 1},
+            {1, 0},
+    };
+    assert(swapped.determinant() == -1);
+
+    // большие целочисленные системы с переполнением NumberType внутри; n = 120 считается за десятые доли секунды
+    for (size_t m: {24, 120}) {
+        RationalMatrix big(m, m), pattern(m, m);
+        std::vector<Rational> expected(m), right(m);
+        uint64_t state = 12345;
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                big(i, j) = static_cast<NumberType>((state >> 33) % 19) - 9;
+                pattern(i, j) = static_cast<NumberType>((i * 7 + j * 13 + i * j) % 19) - 9;
+            }
+            expected[i] = {static_cast<NumberType>(i) - 5, static_cast<NumberType>(i + 1)};
+        }
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < m; ++j) right[i] += big(i, j) * expected[j];
+        }
+        assert(pattern.rank() == 19);
+        assert(pattern.determinant() == 0);
+        assert(big.rank() == m);
+        assert(big.solve(right) == expected);
+    }
 }
 
+void test_chars() {
+    char buffer[128];
+    auto format = [&](const Rational &value) {
+        auto result = toChars(buffer, buffer + sizeof(buffer), value);
+        assert(result.ec == std::errc());
+        return std::string(buffer, result.ptr);
+    };
+    auto format_decimal = [&](const Rational &value, int precision) {
+        auto result = toChars(buffer, buffer + sizeof(buffer), value, precision);
+        assert(result.ec == std::errc());
+        return std::string(buffer, result.ptr);
+    };
+    auto parse = [](const std::string &text) {
+        Rational value;
+        auto result = fromChars(text.data(), text.data() + text.size(), value);
+        assert(result.ec == std::errc() && result.ptr == text.data() + text.size());
+        return value;
+    };
+
+    NumberType minimum = std::numeric_limits<NumberType>::min(), one = 1;
+    assert(format(Rational(3, 4)) == "3/4");
+    assert(format(Rational(1, -2)) == "-1/2");
+    assert(format(Rational(0)) == "0/1");
+    assert(format(Rational(minimum, one)) == "-9223372036854775808/1");
+    Rational huge = Rational(BigInteger::powerOfTwo(100), BigInteger(-3));
+    assert(format(huge) == "-1267650600228229401496703205376/3");
+
+    assert(format_decimal(Rational(1, 3), 5) == "0.33333");
+    assert(format_decimal(Rational(2, 3), 3) == "0.667");
+    assert(format_decimal(Rational(-1, 8), 2) == "-0.13");
+    assert(format_decimal(Rational(-1, 1000), 2) == "0.00");
+    assert(format_decimal(Rational(999, 1000), 2) == "1.00");
+    assert(format_decimal(Rational(-19995, 10), 2) == "-1999.50");
+    assert(format_decimal(Rational(7, 2), 0) == "4");
+    assert(format_decimal(huge, 3) == "-422550200076076467165567735125.333");
+    assert(format_decimal(Rational(BigInteger(1), BigInteger::powerOfTwo(70)), 22) == "0.0000000000000000000008");
+
+    assert(parse("3/4") == Rational(3, 4));
+    assert(parse("-6/8") == Rational(-3, 4));
+    assert(parse("+42") == Rational(42));
+    assert(parse("1.25") == Rational(5, 4));
+    assert(parse("-.5") == Rational(-1, 2));
+    assert(parse("2.5e-3") == Rational(1, 400));
+    assert(parse("1E3") == Rational(1000));
+    assert(parse("-9223372036854775808/1") == Rational(minimum, one));
+    assert(parse("-1267650600228229401496703205376/3") == huge);
+    assert(parse("0.1e-30") == Rational(BigInteger(1), BinaryPower(BigInteger(10), 31)));
+    std::string digits = "123456789012345678901234567890";
+    BigInteger long_integer = BigInteger::fromDigits(digits.data(), digits.data() + digits.size());
+    assert(parse(digits) == Rational(long_integer, BigInteger(1)));
+    assert(parse(digits + ".5") == Rational(long_integer * BigInteger(10) + BigInteger(5), BigInteger(10)));
+
+    // ошибки: значение не меняется, ptr на начале
+    std::string bad[] = {"", "-", "abc", "1/0", "1/", "/2", ".", "1e999999999"};
+    for (const auto &text: bad) {
+        Rational value(7);
+        auto result = fromChars(text.data(), text.data() + text.size(), value);
+        assert(result.ec != std::errc() && result.ptr == text.data());
+        assert(value == Rational(7));
+    }
+    // разбор останавливается на первом лишнем символе
+    std::string partial = "5/6 rest";
+    Rational value;
+    auto result = fromChars(partial.data(), partial.data() + partial.size(), value);
+    assert(result.ec == std::errc() && result.ptr == partial.data() + 3 && value == Rational(5, 6));
+
+    // круговой обмен через файл
+    std::vector<Rational> values;
+    for (NumberType i = 1; i <= 100000; ++i) values.emplace_back(i * (i % 2 == 0 ? 1 : -1), i * i + 1);
+    values.push_back(huge);
+    values.emplace_back(BigInteger(1), BinaryPower(BigInteger(7), 30000)); // длиннее буфера
+    auto path = std::filesystem::temp_directory_path() / "task7_rationals.txt";
+    writeRationals(path, values);
+    std::vector<Rational> read = readRationals(path);
+    std::filesystem::remove(path);
+    assert(read == values);
+}
+
+void test_constexpr() {
+    static_assert(gcd(84, 36) == 12);
+    static_assert(BinaryPower(3, 5) == 243);
+    static_assert(Rational(1, 2) + Rational(1, 3) == Rational(5, 6));
+    static_assert(intPow(Rational(2, 3), 3) == Rational(8, 27));
+    static_assert(bernoulli16[1] == Rational(1, 2));
+    static_assert(bernoulli16[12] == Rational(-691, 2730));
+    static_assert(bernoulli16[16] == Rational(-3617, 510));
+    static_assert(tanTaylor17[3] == Rational(1, 3));
+    static_assert(tanTaylor17[5] == Rational(2, 15));
+    static_assert(tanTaylor17[15] == Rational(929569, 638512875));
+    static_assert(tanTaylor17[17] == Rational(NumberType(6404582), NumberType(10854718875)));
+    // промежуточные значения могут уходить в BigInteger
+    static_assert((Rational(std::numeric_limits<NumberType>::max()) * Rational(4) / Rational(8)).isSmall());
+
+    for (size_t k = 0; k < bernoulli16.size(); ++k) {
+        assert(bernoulli16[k] == BernoulliTable::get(k));
+    }
+    for (double x = -0.3; x < 0.3; x += 0.01) {
+        assert(fabs(evaluateTaylor<tanTaylor17>(x) - tan(x)) < 1e-12);
+    }
+}
 
 int main() {
     test_rational_number();
-
-    int max_k = 8;
+    test_big_rational();
+    test_normalization();
+    test_bernoulli();
+    test_rational_array();
+    test_constexpr();
+    test_expression_templates();
+    test_series();
+    test_matrix();
+    test_chars();
+    test_from_double();
+
+    constexpr int max_k = 8;
 
 //    for (int k = 1; k <= max_k; ++k) {
 //        std::cout << "k = " << k << ": ";
@@ -427,8 +655,16 @@ int main() {
 //    }
 
 
-    auto BernoulliNumbers = getBernoulliNumbers(2 * max_k);
+    // Таблица посчитана при компиляции
+    constexpr auto BernoulliNumbers = bernoulliNumbers<2 * max_k>();
     for (int k = 1; k <= max_k; ++k) {
-        std::cout << "B_" << 2 * k << " = " << BernoulliNumbers[2 * k - 1] << std::endl;
+        std::cout << "B_" << 2 * k << " = " << BernoulliNumbers[2 * k] << std::endl;
     }
+
+    // Раньше после B_30 получался мусор из-за переполнения
+    auto LargeBernoulliNumbers = getBernoulliNumbers(60);
+    std::stringstream s;
+    s << LargeBernoulliNumbers[29] << " " << LargeBernoulliNumbers[59];
+    assert(s.str() == "8615841276005/14322 -1215233140483755572040304994079820246041491/56786730");
+    std::cout << "B_60 = " << LargeBernoulliNumbers[59] << std::endl;
 }
\ No newline at end of file
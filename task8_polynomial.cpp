@@ -3,227 +3,1954 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <complex>
+#include <numbers>
+#include <algorithm>
+#include <random>
+#include <bit>
+#include <stdexcept>
+#include <thread>
+#include <barrier>
+#include <array>
+#include <memory>
+#include <functional>
+#include <iterator>
+#include <initializer_list>
+#include <queue>
+#include <tuple>
+#include <cstdint>
+#include <chrono>
+#include <type_traits>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "rational_numbers.h"
+
+
+/// Вектор, который хранит до InlineCapacity элементов внутри себя и обращается к куче только при росте сверх этого.
+/// Умеет ровно то, что нужно коэффициентам многочлена
+template<typename T, size_t InlineCapacity>
+class SmallVector {
+public:
+    SmallVector() = default;
+
+    SmallVector(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+    }
+
+    explicit SmallVector(const std::vector<T> &values) {
+        assign(values.data(), values.data() + values.size());
+    }
+
+    SmallVector(const SmallVector &other) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    SmallVector &operator=(const SmallVector &other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this == &other) return *this;
+        if (other._heap) {
+            // забираем буфер из кучи целиком
+            _heap = std::move(other._heap);
+            _data = _heap.get();
+            _size = other._size;
+            _capacity = other._capacity;
+            other._data = other._inline.data();
+            other._capacity = InlineCapacity;
+        } else {
+            assign(other.begin(), other.end());
+        }
+        other._size = 0;
+        return *this;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    T *data() {
+        return _data;
+    }
+
+    const T *data() const {
+        return _data;
+    }
+
+    T &operator[](size_t i) {
+        return _data[i];
+    }
+
+    const T &operator[](size_t i) const {
+        return _data[i];
+    }
+
+    T *begin() {
+        return _data;
+    }
+
+    T *end() {
+        return _data + _size;
+    }
+
+    const T *begin() const {
+        return _data;
+    }
+
+    const T *end() const {
+        return _data + _size;
+    }
+
+    std::reverse_iterator<const T *> rbegin() const {
+        return std::reverse_iterator<const T *>(end());
+    }
+
+    std::reverse_iterator<const T *> rend() const {
+        return std::reverse_iterator<const T *>(begin());
+    }
+
+    T &back() {
+        return _data[_size - 1];
+    }
+
+    const T &back() const {
+        return _data[_size - 1];
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity <= _capacity) return;
+
+        auto heap = std::make_unique<T[]>(capacity);
+        std::move(_data, _data + _size, heap.get());
+        _heap = std::move(heap);
+        _data = _heap.get();
+        _capacity = capacity;
+    }
+
+    /// Новые элементы заполняются T(), уменьшение не освобождает память
+    void resize(size_t size) {
+        if (size > _capacity) reserve(std::max(size, 2 * _capacity));
+        if (size > _size) std::fill(_data + _size, _data + size, T());
+        _size = size;
+    }
+
+    void push_back(const T &value) {
+        if (_size == _capacity) reserve(2 * _capacity);
+        _data[_size++] = value;
+    }
+
+    void assign(const T *first, const T *last) {
+        auto size = static_cast<size_t>(last - first);
+        if (size > _capacity) {
+            _size = 0; // старое содержимое не нужно, не переносим его
+            reserve(size);
+        }
+        std::copy(first, last, _data);
+        _size = size;
+    }
+
+    void swap(SmallVector &other) noexcept {
+        SmallVector temporary = std::move(other);
+        other = std::move(*this);
+        *this = std::move(temporary);
+    }
+
+private:
+    std::array<T, InlineCapacity> _inline{};
+    std::unique_ptr<T[]> _heap;
+    T *_data = _inline.data();
+    size_t _size = 0, _capacity = InlineCapacity;
+};
+
+
+/// Вычет по простому модулю Modulus < 2^32
+template<uint32_t Modulus>
+class ModInt {
+    static_assert(Modulus > 1);
+
+public:
+    static constexpr uint32_t modulus = Modulus;
+
+    constexpr ModInt() = default;
+
+    constexpr ModInt(int64_t value)
+            : _value(static_cast<uint32_t>((value % static_cast<int64_t>(Modulus) + Modulus) % Modulus)) {}
+
+    [[nodiscard]] constexpr uint32_t value() const {
+        return _value;
+    }
+
+    constexpr ModInt &operator+=(ModInt other) {
+        uint64_t sum = uint64_t(_value) + other._value;
+        _value = static_cast<uint32_t>(sum >= Modulus ? sum - Modulus : sum);
+        return *this;
+    }
+
+    constexpr ModInt &operator-=(ModInt other) {
+        uint64_t difference = uint64_t(_value) + Modulus - other._value;
+        _value = static_cast<uint32_t>(difference >= Modulus ? difference - Modulus : difference);
+        return *this;
+    }
+
+    constexpr ModInt &operator*=(ModInt other) {
+        _value = static_cast<uint32_t>(uint64_t(_value) * other._value % Modulus);
+        return *this;
+    }
+
+    constexpr ModInt &operator/=(ModInt other) {
+        return *this *= other.inverse();
+    }
+
+    friend constexpr ModInt operator+(ModInt lhs, ModInt rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr ModInt operator-(ModInt lhs, ModInt rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr ModInt operator*(ModInt lhs, ModInt rhs) {
+        return lhs *= rhs;
+    }
+
+    friend constexpr ModInt operator/(ModInt lhs, ModInt rhs) {
+        return lhs /= rhs;
+    }
+
+    constexpr ModInt operator-() const {
+        return ModInt() - *this;
+    }
+
+    constexpr bool operator==(const ModInt &other) const = default;
+
+    friend std::ostream &operator<<(std::ostream &out, ModInt value) {
+        return out << value._value;
+    }
+
+    [[nodiscard]] constexpr ModInt pow(uint64_t power) const {
+        ModInt result = 1, base = *this;
+        for (; power != 0; power >>= 1) {
+            if ((power & 1) != 0) result *= base;
+            base *= base;
+        }
+        return result;
+    }
+
+    /// Обратный по малой теореме Ферма, модуль должен быть простым
+    [[nodiscard]] constexpr ModInt inverse() const {
+        if (_value == 0) throw std::domain_error("ModInt inverse of zero");
+        return pow(Modulus - 2);
+    }
+
+    /// Поддерживает ли модуль NTT длины хотя бы length: степень двойки должна делить Modulus - 1
+    static constexpr bool supports_ntt(size_t length) {
+        return std::bit_width(std::bit_ceil(length)) - 1 <= static_cast<size_t>(std::countr_zero(Modulus - 1));
+    }
+
+    /// Первообразный корень из единицы степени order (степень двойки, делящая Modulus - 1): g^((Modulus - 1) / order)
+    /// для квадратичного невычета g. Его порядок ровно order, так как g^((Modulus - 1) / 2) = -1
+    static constexpr ModInt root_of_unity(uint64_t order) {
+        return non_residue().pow((Modulus - 1) / order);
+    }
+
+private:
+    /// Наименьший квадратичный невычет по критерию Эйлера
+    static constexpr ModInt non_residue() {
+        for (uint32_t g = 2;; ++g) {
+            if (ModInt(g).pow((Modulus - 1) / 2) == ModInt(-1)) return g;
+        }
+    }
+
+    uint32_t _value = 0;
+};
+
+template<typename T>
+constexpr bool is_mod_int = false;
+
+template<uint32_t Modulus>
+constexpr bool is_mod_int<ModInt<Modulus>> = true;
+
+/// Член разреженного многочлена koef * x^degree
+struct Monom {
+    uint64_t degree;
+    double koef;
+
+    bool operator==(const Monom &other) const = default;
+};
+
+/// Произведение двух списков членов, упорядоченных по возрастанию степени, слиянием через кучу (алгоритм Джонсона):
+/// в куче по одному кандидату на член меньшего списка, члены результата выходят уже упорядоченными.
+/// O(n m log min(n, m)) по числу членов и O(min(n, m)) дополнительной памяти, от степени не зависит
+inline std::vector<Monom> multiply_monoms(const std::vector<Monom> &lhs, const std::vector<Monom> &rhs) {
+    const std::vector<Monom> &a = lhs.size() <= rhs.size() ? lhs : rhs, &b = lhs.size() <= rhs.size() ? rhs : lhs;
+    std::vector<Monom> result;
+    if (a.empty()) return result;
+
+    // (степень a_i * b_j, i, j), минимальная степень наверху
+    using Candidate = std::tuple<uint64_t, size_t, size_t>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> heap;
+    for (size_t i = 0; i < a.size(); ++i) heap.emplace(a[i].degree + b[0].degree, i, 0);
+
+    while (!heap.empty()) {
+        auto [degree, i, j] = heap.top();
+        heap.pop();
+
+        double koef = a[i].koef * b[j].koef;
+        if (!result.empty() && result.back().degree == degree) {
+            result.back().koef += koef;
+        } else {
+            if (!result.empty() && result.back().koef == 0.0) result.pop_back(); // взаимно сократились
+            result.push_back({degree, koef});
+        }
+        if (j + 1 < b.size()) heap.emplace(a[i].degree + b[j + 1].degree, i, j + 1);
+    }
+    if (!result.empty() && result.back().koef == 0.0) result.pop_back();
+    return result;
+}
+
+class SparsePolynomial;
+
+/// Многочлен с коэффициентами типа T: double, Rational или вычеты ModInt. Для T нужны +, -, *, /, == и T() как ноль.
+/// Умножение выбирается по типу: БПФ только для double, NTT для ModInt с подходящим модулем, иначе Карацуба
+template<typename T>
+class BasicPolynomial {
+public:
+
+    /// Если меньший из сомножителей короче, умножаем в столбик
+    inline static size_t karatsuba_threshold = 64;
+
+    /// Начиная с такой длины меньшего сомножителя умножаем через БПФ (для вычетов - через NTT)
+    inline static size_t fft_threshold = 256;
+
+    /// Если и частное, и делитель не короче, делим через обращение ряда методом Ньютона
+    inline static size_t newton_division_threshold = 64;
+
+    /// Если доля ненулевых коэффициентов не больше, многочлен считается разреженным: при умножении двух таких длинных
+    /// сомножителей берём разреженное умножение, и SparsePolynomial::prefers_sparse советует то же по тому же порогу
+    inline static double sparse_density_threshold = 0.02;
+
+    /// С такого числа точек evaluate делит массив между потоками
+    inline static size_t parallel_evaluation_threshold = 1 << 16;
+
+    /// В дереве остатков узлы не больше чем на столько точек считаются напрямую Горнером
+    inline static size_t subproduct_leaf_size = 32;
+
+    /// Для T с плавающей точкой evaluate_multipoint на большем числе точек считает пакетным Горнером: остатки дерева в
+    /// мономиальном базисе теряют точность (на [-1, 1] ошибка около 1e-10 при 64 точках и 1e9 при 128)
+    inline static size_t floating_multipoint_limit = 64;
+
+    /// С такой степени поправки корней в roots считаются в нескольких потоках
+    inline static size_t parallel_roots_threshold = 64;
+
+    /// В compose куски многочлена не длиннее считаются схемой Горнера, длинные делятся пополам
+    inline static size_t composition_threshold = 16;
+
+    /// Столько коэффициентов хранится без выделения памяти
+    static constexpr size_t inline_capacity = 16;
+
+    using Storage = SmallVector<T, inline_capacity>;
+
+    BasicPolynomial() : _koefs({T()}) {};
+
+    explicit BasicPolynomial(const std::vector<T> &vec) : _koefs(vec) {
+        if (vec.empty()) { _koefs = {T()}; };
+    }
+
+    BasicPolynomial(std::initializer_list<T> koefs) : _koefs(koefs) {
+        if (_koefs.empty()) { _koefs = {T()}; };
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const BasicPolynomial &poly) {
+        for (size_t i = poly._koefs.size() - 1; i > 0; --i) {
+            out << poly._koefs[i] << "x^" << i << " + ";
+        }
+
+        out << poly._koefs[0];
+
+
+        return out;
+    }
+
+    T operator()(const T &x) const {
+        T _x = T(1);
+        T res = T();
+
+        for (const T &koef: _koefs) {
+            res += koef * _x;
+            _x *= x;
+        }
+
+        return res;
+    }
+
+    /// out[i] = P(xs[i]) для i < count. Схема Горнера идёт сразу по блоку точек: независимые цепочки
+    /// не ждут друг друга, для double они лежат в регистрах AVX или SSE2. Большие массивы делятся между потоками
+    void evaluate(const T *xs, size_t count, T *out) const {
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        if (count < parallel_evaluation_threshold || threads == 1) {
+            evaluate_block(_koefs.data(), _koefs.size(), xs, count, out);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (size_t begin = chunk; begin < count; begin += chunk) {
+            workers.emplace_back(evaluate_block, _koefs.data(), _koefs.size(), xs + begin,
+                                 std::min(chunk, count - begin), out + begin);
+        }
+        evaluate_block(_koefs.data(), _koefs.size(), xs, std::min(chunk, count), out);
+        for (auto &worker: workers) worker.join();
+    }
+
+    std::vector<T> evaluate(const std::vector<T> &xs) const {
+        std::vector<T> result(xs.size());
+        evaluate(xs.data(), xs.size(), result.data());
+        return result;
+    }
+
+    /// Горнер по lanes точкам одновременно, хвост - по одной. Для double блоки считает evaluate_lanes
+    static void evaluate_block(const T *koefs, size_t size, const T *xs, size_t count, T *out) {
+        constexpr size_t lanes = 8;
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        if constexpr (std::is_same_v<T, double>) i = evaluate_lanes(koefs, size, xs, count, out);
+#endif
+        for (; i + lanes <= count; i += lanes) {
+            T x[lanes], acc[lanes];
+            for (size_t j = 0; j < lanes; ++j) {
+                x[j] = xs[i + j];
+                acc[j] = koefs[size - 1];
+            }
+            for (size_t k = size - 1; k-- > 0;) {
+                for (size_t j = 0; j < lanes; ++j) acc[j] = acc[j] * x[j] + koefs[k];
+            }
+            for (size_t j = 0; j < lanes; ++j) out[i + j] = acc[j];
+        }
+        for (; i < count; ++i) {
+            T acc = koefs[size - 1];
+            for (size_t k = size - 1; k-- > 0;) acc = acc * xs[i] + koefs[k];
+            out[i] = acc;
+        }
+    }
+
+#if defined(__AVX__)
+    /// Горнер по 16 точкам в четырёх регистрах AVX: четыре независимые цепочки прячут задержку умножения
+    /// и сложения. Без FMA, чтобы результат совпадал с хвостом. Возвращает число посчитанных точек
+    static size_t evaluate_lanes(const double *koefs, size_t size, const double *xs, size_t count, double *out) {
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256d x0 = _mm256_loadu_pd(xs + i), x1 = _mm256_loadu_pd(xs + i + 4);
+            __m256d x2 = _mm256_loadu_pd(xs + i + 8), x3 = _mm256_loadu_pd(xs + i + 12);
+            __m256d acc0 = _mm256_set1_pd(koefs[size - 1]), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t k = size - 1; k-- > 0;) {
+                __m256d koef = _mm256_set1_pd(koefs[k]);
+                acc0 = _mm256_add_pd(_mm256_mul_pd(acc0, x0), koef);
+                acc1 = _mm256_add_pd(_mm256_mul_pd(acc1, x1), koef);
+                acc2 = _mm256_add_pd(_mm256_mul_pd(acc2, x2), koef);
+                acc3 = _mm256_add_pd(_mm256_mul_pd(acc3, x3), koef);
+            }
+            _mm256_storeu_pd(out + i, acc0);
+            _mm256_storeu_pd(out + i + 4, acc1);
+            _mm256_storeu_pd(out + i + 8, acc2);
+            _mm256_storeu_pd(out + i + 12, acc3);
+        }
+        return i;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    /// Горнер по 8 точкам в четырёх регистрах SSE2: четыре независимые цепочки прячут задержку умножения
+    /// и сложения. Возвращает число посчитанных точек
+    static size_t evaluate_lanes(const double *koefs, size_t size, const double *xs, size_t count, double *out) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128d x0 = _mm_loadu_pd(xs + i), x1 = _mm_loadu_pd(xs + i + 2);
+            __m128d x2 = _mm_loadu_pd(xs + i + 4), x3 = _mm_loadu_pd(xs + i + 6);
+            __m128d acc0 = _mm_set1_pd(koefs[size - 1]), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t k = size - 1; k-- > 0;) {
+                __m128d koef = _mm_set1_pd(koefs[k]);
+                acc0 = _mm_add_pd(_mm_mul_pd(acc0, x0), koef);
+                acc1 = _mm_add_pd(_mm_mul_pd(acc1, x1), koef);
+                acc2 = _mm_add_pd(_mm_mul_pd(acc2, x2), koef);
+                acc3 = _mm_add_pd(_mm_mul_pd(acc3, x3), koef);
+            }
+            _mm_storeu_pd(out + i, acc0);
+            _mm_storeu_pd(out + i + 2, acc1);
+            _mm_storeu_pd(out + i + 4, acc2);
+            _mm_storeu_pd(out + i + 6, acc3);
+        }
+        return i;
+    }
+#endif
+
+    /// Все комплексные корни с кратностью (только для double), порядок не определён.
+    /// Одновременные итерации Аберта–Эрлиха: z_i -= r_i / (1 - r_i sum_{j != i} 1 / (z_i - z_j)), где r_i = P(z_i) / P'(z_i).
+    /// Поправки считаются по старым приближениям всех корней (по Якоби), поэтому делятся между потоками;
+    /// в конце каждый корень уточняется несколькими шагами Ньютона
+    std::vector<std::complex<double>> roots(size_t max_iterations = 1000) const {
+        using Complex = std::complex<double>;
+
+        size_t last = significant_size(_koefs);
+        if (last == 0) throw std::domain_error("Polynomial roots of zero polynomial");
+        size_t zeros = 0;
+        while (_koefs[zeros] == 0.0) ++zeros; // корни в нуле отделяем сразу
+
+        std::vector<Complex> result(zeros, Complex());
+        BasicPolynomial reduced_poly(std::vector<double>(_koefs.begin() + zeros, _koefs.begin() + last)); // NOLINT(*-narrowing-conversions)
+        size_t n = reduced_poly.getDegree();
+        if (n == 0) return result;
+
+        RootFinder finder(reduced_poly);
+        std::vector<Complex> z(n), step(n);
+
+        // Начальные приближения на окружности радиуса среднего геометрического модулей корней,
+        // со сдвигом угла, чтобы не попасть в симметрию вещественных коэффициентов
+        double radius = std::pow(std::abs(reduced_poly._koefs[0] / reduced_poly._koefs[n]), 1.0 / static_cast<double>(n));
+        for (size_t i = 0; i < n; ++i) {
+            z[i] = std::polar(radius, 2 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(n) + 0.4);
+        }
+
+        auto correct = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Complex ratio = finder.newton_step(z[i]), sum;
+                for (size_t j = 0; j < n; ++j) {
+                    if (j != i) sum += 1.0 / (z[i] - z[j]);
+                }
+                step[i] = ratio / (1.0 - ratio * sum);
+            }
+        };
+
+        size_t iteration = 0;
+        bool done = false;
+        auto apply = [&]() noexcept {
+            bool converged = true;
+            for (size_t i = 0; i < n; ++i) {
+                z[i] -= step[i];
+                if (!(std::abs(step[i]) <= 4 * std::numeric_limits<double>::epsilon() * std::abs(z[i]))) converged = false;
+            }
+            done = converged || ++iteration >= max_iterations;
+        };
+
+        size_t threads = n < parallel_roots_threshold ? 1 : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, n);
+        if (threads == 1) {
+            while (!done) {
+                correct(0, n);
+                apply();
+            }
+        } else {
+            std::barrier sync(static_cast<std::ptrdiff_t>(threads), apply);
+            auto worker = [&](size_t begin, size_t end) {
+                while (!done) {
+                    correct(begin, end);
+                    sync.arrive_and_wait(); // последний пришедший применяет поправки и проверяет сходимость
+                }
+            };
+            std::vector<std::thread> workers;
+            size_t chunk = (n + threads - 1) / threads;
+            for (size_t begin = chunk; begin < n; begin += chunk) workers.emplace_back(worker, begin, std::min(n, begin + chunk));
+            worker(0, std::min(n, chunk));
+            for (auto &thread: workers) thread.join();
+        }
+
+        for (Complex &root: z) {
+            for (int i = 0; i < 3; ++i) {
+                Complex newton = finder.newton_step(root);
+                if (!std::isfinite(newton.real()) || !std::isfinite(newton.imag())) break;
+                root -= newton;
+                if (std::abs(newton) <= std::numeric_limits<double>::epsilon() * std::abs(root)) break;
+            }
+        }
+
+        result.insert(result.end(), z.begin(), z.end());
+        return result;
+    }
+
+    /// Значения в n точках за O(M(n) log n) через дерево остатков: остаток от деления на произведение
+    /// (x - x_i) по узлу дерева спускается к детям, в маленьких узлах считаем Горнером.
+    /// Оценка O(M(n) log n) верна только для точных колец (Rational, ModInt): для T с плавающей точкой больше
+    /// floating_multipoint_limit точек считаются пакетным evaluate за O(n * deg)
+    std::vector<T> evaluate_multipoint(const std::vector<T> &points) const {
+        std::vector<T> result(points.size());
+        if (points.empty()) return result;
+        if constexpr (std::is_floating_point_v<T>) {
+            if (points.size() > floating_multipoint_limit) {
+                evaluate(points.data(), points.size(), result.data());
+                return result;
+            }
+        }
+
+        SubproductTree tree(points);
+        tree.evaluate(*this, result.data());
+        return result;
+    }
+
+    /// Многочлен степени меньше n через n точек за O(M(n) log n): веса Лагранжа y_i / M'(x_i), где M = prod (x - x_j),
+    /// считаются по тому же дереву, а потом линейная комбинация собирается снизу вверх.
+    /// Оценка верна только для точных колец: для T с плавающей точкой при любом n считаются разделённые разности
+    /// Ньютона за O(n^2). Мономиальные коэффициенты по вещественным узлам обусловлены как матрица Вандермонда, то
+    /// есть экспоненциально плохо по n: для прямой 3x + 2 относительная невязка в узлах на [-1, 1] около 1e-8 при
+    /// 49 узлах Чебышёва и 1e-2 при 64, а в целых узлах 0..n-1 ответ точный. Если нужно больше узлов - берите точный
+    /// T или приближение в базисе Чебышёва (PolynomialApproximation)
+    static BasicPolynomial interpolate(const std::vector<T> &xs, const std::vector<T> &ys) {
+        if (xs.size() != ys.size()) throw std::invalid_argument("Polynomial interpolation sizes differ");
+        if (xs.empty()) return {};
+        if constexpr (std::is_floating_point_v<T>) {
+            return interpolate_newton(xs, ys);
+        }
+
+        SubproductTree tree(xs);
+        std::vector<T> weights(xs.size());
+        tree.evaluate(tree.root().derivative(), weights.data());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (weights[i] == T()) throw std::invalid_argument("Polynomial interpolation points repeat");
+            weights[i] = ys[i] / weights[i];
+        }
+
+        BasicPolynomial result = tree.combine(weights, tree.levels.size() - 1, 0);
+        result.reduce();
+        return result;
+    }
+
+    /// this[i] = operation(this[i], other[i]) на месте, недостающие коэффициенты считаются нулями
+    template<typename Operation>
+    BasicPolynomial &apply_addictive(const BasicPolynomial &other, Operation operation) {
+        if (other._koefs.size() > _koefs.size()) _koefs.resize(other._koefs.size());
+        const T *rhs = other._koefs.data();
+        T *lhs = _koefs.data();
+        for (size_t i = 0; i < other._koefs.size(); ++i) {
+            lhs[i] = operation(lhs[i], rhs[i]);
+        }
+        return *this;
+    }
+
+    BasicPolynomial &operator+=(const BasicPolynomial &other) {
+        return apply_addictive(other, std::plus<>());
+    }
+
+    BasicPolynomial &operator-=(const BasicPolynomial &other) {
+        return apply_addictive(other, std::minus<>());
+    }
+
+    /// Временные операнды переиспользуются как результат, новая память не выделяется
+    friend BasicPolynomial operator+(BasicPolynomial lhs, const BasicPolynomial &rhs) {
+        lhs += rhs;
+        return lhs;
+    }
+
+    friend BasicPolynomial operator+(const BasicPolynomial &lhs, BasicPolynomial &&rhs) {
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    friend BasicPolynomial operator-(BasicPolynomial lhs, const BasicPolynomial &rhs) {
+        lhs -= rhs;
+        return lhs;
+    }
+
+    friend BasicPolynomial operator-(const BasicPolynomial &lhs, BasicPolynomial &&rhs) {
+        rhs.negate();
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    BasicPolynomial operator-() const & {
+        BasicPolynomial result = *this;
+        result.negate();
+        return result;
+    }
+
+    BasicPolynomial operator-() && {
+        negate();
+        return std::move(*this);
+    }
+
+    void negate() {
+        for (T &koef: _koefs) koef = -koef;
+    }
+
+    /// Столбиком - прямо на месте, от старших коэффициентов к младшим; длинные сомножители - через буфер
+    BasicPolynomial &operator*=(const BasicPolynomial &other) {
+        size_t n = _koefs.size(), m = other._koefs.size();
+        if (&other == this || std::min(n, m) >= karatsuba_threshold) {
+            Storage result;
+            result.resize(n + m - 1);
+            multiply(_koefs.data(), n, other._koefs.data(), m, result.data());
+            _koefs.swap(result);
+        } else {
+            _koefs.resize(n + m - 1);
+            T *koefs = _koefs.data();
+            const T *rhs = other._koefs.data();
+            for (size_t i = n; i-- > 0;) {
+                T factor = koefs[i];
+                koefs[i] = T();
+                for (size_t j = 0; j < m; ++j) koefs[i + j] += factor * rhs[j];
+            }
+        }
+        reduce(); // при умножении на 0 может быть такое
+        return *this;
+    }
+
+    friend BasicPolynomial operator*(BasicPolynomial lhs, const BasicPolynomial &rhs) {
+        lhs *= rhs;
+        return lhs;
+    }
+
+    friend BasicPolynomial operator*(const BasicPolynomial &lhs, BasicPolynomial &&rhs) {
+        rhs *= lhs;
+        return std::move(rhs);
+    }
+
+    BasicPolynomial multiply_monom(const unsigned int degree) const {
+        BasicPolynomial result;
+        result._koefs.resize(_koefs.size() + degree);
+        std::copy(_koefs.begin(), _koefs.end(), result._koefs.begin() + degree);
+        return result;
+    }
+
+    bool operator==(const BasicPolynomial &other) const {
+        if (_koefs.size() != other._koefs.size()) return false;
+
+        for (size_t i = 0; i < _koefs.size(); ++i) {
+            if (_koefs[i] != other._koefs[i]) return false;
+        }
+
+        return true;
+    }
+
+    BasicPolynomial derivative() const {
+        if (_koefs.size() == 1) return BasicPolynomial({T()});
+
+        BasicPolynomial result;
+        result._koefs.resize(_koefs.size() - 1);
+
+        for (size_t i = 1; i < _koefs.size(); ++i) {
+            result._koefs[i - 1] = T(static_cast<int64_t>(i)) * _koefs[i];
+        }
+
+        return result;
+    }
+
+    /// p(q(x)) делением пополам: p(q) = p_low(q) + q^h p_high(q), где h = composition_threshold * 2^k, а q^h
+    /// берётся из заранее посчитанных повторных квадратов. Склейки идут через быстрое умножение, так что вместо
+    /// O(n^3) выходит O(M(n deg q) log n)
+    BasicPolynomial compose(const BasicPolynomial &q) const {
+        size_t size = significant_size(_koefs);
+        if (size == 0) return BasicPolynomial();
+        std::vector<BasicPolynomial> powers = {q};
+        if (size > composition_threshold) {
+            BasicPolynomial power({T(1)}), base = q;
+            for (size_t exponent = composition_threshold; exponent > 0; exponent >>= 1) {
+                if (exponent & 1) power *= base;
+                if (exponent > 1) base *= base;
+            }
+            powers.push_back(std::move(power));
+        }
+        while ((composition_threshold << (powers.size() - 1)) < size) powers.push_back(powers.back() * powers.back());
+        BasicPolynomial result = compose_block(_koefs.data(), size, powers, powers.size() - 1);
+        result.reduce();
+        return result;
+    }
+
+    /// p(x + a). Над double - на месте повторным делением Горнера на (x - a) за O(n^2) без выделений памяти: быстрые
+    /// умножения через БПФ здесь теряют мелкие коэффициенты на фоне биномиально растущих. В точных кольцах длинные
+    /// многочлены сдвигаются через compose
+    BasicPolynomial shift(const T &a) const {
+        if constexpr (!std::is_same_v<T, double>) {
+            if (_koefs.size() > composition_threshold) return compose(BasicPolynomial({a, T(1)}));
+        }
+        BasicPolynomial result = *this;
+        T *koefs = result._koefs.data();
+        size_t size = result._koefs.size();
+        for (size_t i = 0; i + 1 < size; ++i) {
+            for (size_t j = size - 1; j-- > i;) koefs[j] += a * koefs[j + 1];
+        }
+        return result;
+    }
+
+    /// result[0, n + m - 1) += a * b; выбирает алгоритм по длине меньшего сомножителя
+    static void multiply(const T *a, size_t n, const T *b, size_t m, T *result) {
+        size_t smaller = std::min(n, m);
+        if (smaller < karatsuba_threshold) {
+            multiply_naive(a, n, b, m, result);
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, double>) {
+            if (is_sparse(a, n) && is_sparse(b, m)) {
+                multiply_sparse(a, n, b, m, result);
+                return;
+            }
+            if (smaller >= fft_threshold) {
+                multiply_fft(a, n, b, m, result);
+                return;
+            }
+        } else if constexpr (is_mod_int<T>) {
+            if (smaller >= fft_threshold && T::supports_ntt(n + m - 1)) {
+                multiply_ntt(a, n, b, m, result);
+                return;
+            }
+        }
+        multiply_karatsuba(a, n, b, m, result);
+    }
+
+    /// Умножение только ненулевых членов слиянием через кучу, см. multiply_monoms
+    static void multiply_sparse(const double *a, size_t n, const double *b, size_t m, double *result) {
+        for (const Monom &monom: multiply_monoms(to_monoms(a, n), to_monoms(b, m))) {
+            result[monom.degree] += monom.koef;
+        }
+    }
+
+    /// Умножение в столбик, O(n m)
+    static void multiply_naive(const T *a, size_t n, const T *b, size_t m, T *result) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                result[i + j] += a[i] * b[j];
+            }
+        }
+    }
+
+    /// Карацуба, O(n^log2(3)). Длинный сомножитель режется на куски длины короткого
+    static void multiply_karatsuba(const T *a, size_t n, const T *b, size_t m, T *result) {
+        if (n < m) {
+            std::swap(a, b);
+            std::swap(n, m);
+        }
+        if (m < karatsuba_threshold || m < 2) {
+            multiply_naive(a, n, b, m, result);
+            return;
+        }
+        if (n > m) {
+            for (size_t shift = 0; shift < n; shift += m) {
+                multiply_karatsuba(a + shift, std::min(m, n - shift), b, m, result + shift);
+            }
+            return;
+        }
+
+        // a = a0 + x^h a1, b = b0 + x^h b1
+        size_t h = n / 2, high = n - h;
+        std::vector<T> a_sum(a + h, a + n), b_sum(b + h, b + n);
+        for (size_t i = 0; i < h; ++i) {
+            a_sum[i] += a[i];
+            b_sum[i] += b[i];
+        }
+
+        std::vector<T> z0(2 * h - 1), z1(2 * high - 1), z2(2 * high - 1);
+        multiply_karatsuba(a, h, b, h, z0.data());
+        multiply_karatsuba(a + h, high, b + h, high, z2.data());
+        multiply_karatsuba(a_sum.data(), high, b_sum.data(), high, z1.data());
+
+        for (size_t i = 0; i < z0.size(); ++i) {
+            result[i] += z0[i];
+            z1[i] -= z0[i];
+        }
+        for (size_t i = 0; i < z2.size(); ++i) {
+            result[i + 2 * h] += z2[i];
+            z1[i] -= z2[i];
+        }
+        for (size_t i = 0; i < z1.size(); ++i) result[i + h] += z1[i];
+    }
+
+    /// Свёртка через комплексное БПФ, O((n + m) log(n + m)). Оба сомножителя упаковываются в одно
+    /// комплексное преобразование (a в действительную часть, b в мнимую). Погрешность абсолютная,
+    /// порядка eps log(n + m) max|a| max|b|; если оба сомножителя целые и результат заведомо
+    /// меньше 2^50, коэффициенты округляются и произведение получается точным
+    static void multiply_fft(const double *a, size_t n, const double *b, size_t m, double *result) {
+        size_t length = n + m - 1, size = std::bit_ceil(length);
+
+        std::vector<std::complex<double>> data(size);
+        for (size_t i = 0; i < n; ++i) data[i].real(a[i]);
+        for (size_t i = 0; i < m; ++i) data[i].imag(b[i]);
+        fft(data, false);
+
+        // A_k = (Z_k + conj Z_{-k}) / 2, B_k = (Z_k - conj Z_{-k}) / 2i, в спектр кладём A_k B_k
+        std::vector<std::complex<double>> product(size);
+        for (size_t k = 0; k < size; ++k) {
+            std::complex<double> z = data[k], mirrored = std::conj(data[(size - k) & (size - 1)]);
+            product[k] = (z + mirrored) * (z - mirrored) * std::complex<double>(0, -0.25);
+        }
+        fft(product, true);
+
+        bool exact = is_integer(a, n) && is_integer(b, m) &&
+                     max_abs(a, n) * max_abs(b, m) * static_cast<double>(std::min(n, m)) < 0x1p50;
+        for (size_t i = 0; i < length; ++i) {
+            double value = product[i].real();
+            result[i] += exact ? std::round(value) : value;
+        }
+    }
+
+    /// Итеративное БПФ по основанию 2 на месте, размер - степень двойки. Корни из единицы считаются
+    /// напрямую через cos/sin, а не последовательным домножением, чтобы не накапливать ошибку
+    static void fft(std::vector<std::complex<double>> &data, bool inverse) {
+        size_t size = data.size();
+        if (size <= 1) return;
+
+        for (size_t i = 1, j = 0; i < size; ++i) {
+            size_t bit = size >> 1;
+            for (; (j & bit) != 0; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(data[i], data[j]);
+        }
+
+        std::vector<std::complex<double>> roots(size / 2);
+        double sign = inverse ? 1 : -1;
+        for (size_t k = 0; k < size / 2; ++k) {
+            double angle = sign * 2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(size);
+            roots[k] = {std::cos(angle), std::sin(angle)};
+        }
+
+        for (size_t half = 1; half < size; half <<= 1) {
+            size_t step = size / (2 * half);
+            for (size_t start = 0; start < size; start += 2 * half) {
+                for (size_t j = 0; j < half; ++j) {
+                    std::complex<double> u = data[start + j], v = data[start + j + half] * roots[j * step];
+                    data[start + j] = u + v;
+                    data[start + j + half] = u - v;
+                }
+            }
+        }
+
+        if (inverse) {
+            for (auto &value: data) value /= static_cast<double>(size);
+        }
+    }
+
+    /// Свёртка через теоретико-числовое преобразование - то же БПФ, но над вычетами, поэтому без погрешности
+    static void multiply_ntt(const T *a, size_t n, const T *b, size_t m, T *result) {
+        size_t length = n + m - 1, size = std::bit_ceil(length);
+        std::vector<T> lhs(a, a + n), rhs(b, b + m);
+        lhs.resize(size);
+        rhs.resize(size);
+        ntt(lhs, false);
+        ntt(rhs, false);
+        for (size_t i = 0; i < size; ++i) lhs[i] *= rhs[i];
+        ntt(lhs, true);
+        for (size_t i = 0; i < length; ++i) result[i] += lhs[i];
+    }
+
+    /// Итеративное NTT по основанию 2 на месте, размер - степень двойки, делящая модуль минус один
+    static void ntt(std::vector<T> &data, bool inverse) {
+        size_t size = data.size();
+        if (size <= 1) return;
+
+        for (size_t i = 1, j = 0; i < size; ++i) {
+            size_t bit = size >> 1;
+            for (; (j & bit) != 0; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(data[i], data[j]);
+        }
+
+        std::vector<T> roots;
+        for (size_t half = 1; half < size; half <<= 1) {
+            T root = T::root_of_unity(2 * half);
+            if (inverse) root = root.inverse();
+            roots.assign(1, T(1));
+            for (size_t j = 1; j < half; ++j) roots.push_back(roots.back() * root);
+
+            for (size_t start = 0; start < size; start += 2 * half) {
+                for (size_t j = 0; j < half; ++j) {
+                    T u = data[start + j], v = data[start + j + half] * roots[j];
+                    data[start + j] = u + v;
+                    data[start + j + half] = u - v;
+                }
+            }
+        }
+
+        if (inverse) {
+            T scale = T(static_cast<int64_t>(size)).inverse();
+            for (auto &value: data) value *= scale;
+        }
+    }
+
+    static void _reduce_vector(Storage &vec) {
+        size_t new_size = 1;
+        for (size_t i = vec.size() - 1; i > 0; --i) { // обязательно оставляем нулевой коэффициент
+            if (vec[i] != T()) {
+                new_size = i + 1;
+                break;
+            }
+        }
+
+        vec.resize(new_size);
+    }
+
+    /// Отбрасывает все старшие степени с нулями
+    void reduce() {
+        _reduce_vector(_koefs);
+    }
+
+    /// Коэффициент при x^i, i <= getDegree()
+    const T &operator[](size_t i) const {
+        return _koefs[i];
+    }
+
+    size_t getDegree() const {
+        return _koefs.size() - 1;
+    }
+
+    /// Возвращает результат деления на divisor в виде (частное, остаток). Для длинных частного и делителя
+    /// делит через обращение ряда (divide_newton), иначе столбиком на месте (divide_long)
+    std::pair<BasicPolynomial, BasicPolynomial> divide(const BasicPolynomial &divisor) const {
+        size_t divisor_size = significant_size(divisor._koefs), self_size = significant_size(_koefs);
+        if (self_size >= divisor_size &&
+            std::min(self_size - divisor_size + 1, divisor_size) >= newton_division_threshold) {
+            return divide_newton(divisor);
+        }
+        return divide_long(divisor);
+    }
+
+    /// Деление столбиком, O(deg q * deg divisor) без промежуточных выделений памяти
+    std::pair<BasicPolynomial, BasicPolynomial> divide_long(const BasicPolynomial &divisor) const {
+        size_t divisor_size = significant_size(divisor._koefs), self_size = significant_size(_koefs);
+        if (divisor_size == 0) throw std::domain_error("Polynomial division by zero");
+        if (self_size < divisor_size) return std::make_pair(BasicPolynomial(), reduced(*this));
+
+        std::vector<T> remainder(_koefs.begin(), _koefs.begin() + self_size); // NOLINT(*-narrowing-conversions)
+        std::vector<T> quotient(self_size - divisor_size + 1);
+        divide_in_place(remainder.data(), self_size, divisor._koefs.data(), divisor_size, quotient.data());
+        // на константу делится нацело; в остатке осталась бы погрешность округления x - (x / d) * d
+        if (divisor_size == 1) remainder.assign(1, T());
+        remainder.resize(std::max<size_t>(divisor_size - 1, 1));
+
+        BasicPolynomial q(quotient), r(remainder);
+        q.reduce();
+        r.reduce();
+        return std::make_pair(q, r);
+    }
+
+    /// Деление через обращение перевёрнутого делителя как степенного ряда: rev(q) = rev(a) / rev(b) mod x^(n-m+1),
+    /// обратный ряд считается итерациями Ньютона g -> g (2 - rev(b) g) с удвоением точности.
+    /// Стоит несколько умножений, то есть O(n log n) при умножении через БПФ
+    std::pair<BasicPolynomial, BasicPolynomial> divide_newton(const BasicPolynomial &divisor) const {
+        size_t divisor_size = significant_size(divisor._koefs), self_size = significant_size(_koefs);
+        if (divisor_size == 0) throw std::domain_error("Polynomial division by zero");
+        if (self_size < divisor_size) return std::make_pair(BasicPolynomial(), reduced(*this));
+
+        size_t quotient_size = self_size - divisor_size + 1;
+        std::vector<T> reversed_divisor(divisor._koefs.rend() - divisor_size, divisor._koefs.rend());
+        std::vector<T> inverse = inverse_series(reversed_divisor.data(), divisor_size, quotient_size);
+
+        std::vector<T> reversed_self(_koefs.rend() - self_size, _koefs.rend());
+        std::vector<T> quotient(quotient_size);
+        multiply_truncated(reversed_self.data(), std::min(self_size, quotient_size), inverse.data(), quotient_size,
+                           quotient.data(), quotient_size);
+        std::reverse(quotient.begin(), quotient.end());
+
+        // r = a - b q, нужны только младшие divisor_size - 1 коэффициентов
+        std::vector<T> remainder(std::max<size_t>(divisor_size - 1, 1));
+        multiply_truncated(divisor._koefs.data(), divisor_size, quotient.data(), quotient_size,
+                           remainder.data(), divisor_size - 1);
+        for (size_t i = 0; i + 1 < divisor_size; ++i) remainder[i] = _koefs[i] - remainder[i];
+
+        BasicPolynomial q(quotient), r(remainder);
+        q.reduce();
+        r.reduce();
+        return std::make_pair(q, r);
+    }
+
+    /// Деление столбиком на месте: dividend[0, n) заменяется остатком (в младших m - 1 коэффициентах),
+    /// частное длины n - m + 1 пишется в quotient. Старший коэффициент divisor[m - 1] ненулевой, n >= m
+    static void divide_in_place(T *dividend, size_t n, const T *divisor, size_t m, T *quotient) {
+        T leading = divisor[m - 1];
+        for (size_t shift = n - m + 1; shift-- > 0;) {
+            T k = dividend[shift + m - 1] / leading;
+            quotient[shift] = k;
+            for (size_t j = 0; j < m; ++j) dividend[shift + j] -= k * divisor[j];
+        }
+    }
+
+    /// Первые count коэффициентов ряда 1 / series, series[0] != 0
+    static std::vector<T> inverse_series(const T *series, size_t size, size_t count) {
+        std::vector<T> inverse = {T(1) / series[0]}, correction;
+        for (size_t precision = 1; precision < count;) {
+            precision = std::min(2 * precision, count);
+
+            // correction = 2 - series * inverse mod x^precision
+            correction.assign(precision, T());
+            multiply_truncated(series, std::min(size, precision), inverse.data(), inverse.size(),
+                               correction.data(), precision);
+            for (T &value: correction) value = -value;
+            correction[0] += T(2);
+
+            std::vector<T> next(precision);
+            multiply_truncated(inverse.data(), inverse.size(), correction.data(), precision, next.data(), precision);
+            inverse = std::move(next);
+        }
+        return inverse;
+    }
+
+    /// result[0, count) = первые count коэффициентов a * b
+    static void multiply_truncated(const T *a, size_t n, const T *b, size_t m, T *result, size_t count) {
+        n = std::min(n, count);
+        m = std::min(m, count);
+        if (count == 0) return;
+        if (n + m - 1 <= count) {
+            std::fill_n(result, count, T());
+            multiply(a, n, b, m, result);
+            return;
+        }
+        std::vector<T> full(n + m - 1);
+        multiply(a, n, b, m, full.data());
+        std::copy_n(full.begin(), count, result);
+    }
+
+private:
+    friend class SparsePolynomial;
+
+    /// Шаг Ньютона P(z) / P'(z) в комплексной точке. При |z| > 1 значения P(z) переполняются уже для степени
+    /// в несколько сотен, поэтому там считаем через перевёрнутый многочлен Q(y) = y^n P(1 / y):
+    /// P(z) / P'(z) = z Q(y) / (n Q(y) - y Q'(y)), y = 1 / z
+    struct RootFinder {
+        explicit RootFinder(const BasicPolynomial &poly)
+                : degree(poly.getDegree()), direct(poly), direct_derivative(poly.derivative()),
+                  reversed(std::vector<double>(poly._koefs.rbegin(), poly._koefs.rend())),
+                  reversed_derivative(reversed.derivative()) {}
+
+        [[nodiscard]] std::complex<double> newton_step(std::complex<double> z) const {
+            if (std::abs(z) <= 1) return horner(direct, z) / horner(direct_derivative, z);
+
+            std::complex<double> y = 1.0 / z, q = horner(reversed, y);
+            return z * q / (static_cast<double>(degree) * q - y * horner(reversed_derivative, y));
+        }
+
+        static std::complex<double> horner(const BasicPolynomial &poly, std::complex<double> z) {
+            std::complex<double> result;
+            for (size_t k = poly._koefs.size(); k-- > 0;) result = result * z + poly._koefs[k];
+            return result;
+        }
+
+        size_t degree;
+        BasicPolynomial direct, direct_derivative, reversed, reversed_derivative;
+    };
 
+    static bool is_sparse(const double *koefs, size_t size) {
+        auto limit = static_cast<size_t>(sparse_density_threshold * static_cast<double>(size));
+        size_t nonzero = 0;
+        for (size_t i = 0; i < size && nonzero <= limit; ++i) nonzero += koefs[i] != 0.0;
+        return nonzero <= limit;
+    }
 
-inline double plus(const double lhs, const double rhs) {
-    return lhs + rhs;
-}
+    static std::vector<Monom> to_monoms(const double *koefs, size_t size) {
+        std::vector<Monom> monoms;
+        for (size_t i = 0; i < size; ++i) {
+            if (koefs[i] != 0.0) monoms.push_back({i, koefs[i]});
+        }
+        return monoms;
+    }
 
-inline double minus(const double lhs, const double rhs) {
-    return lhs - rhs;
-}
+    /// Дерево произведений: levels[0][i] = x - points[i], узел levels[k][j] - произведение по точкам
+    /// [j 2^k, (j + 1) 2^k); непарный последний узел переносится на уровень выше как есть.
+    /// Точки сортируются и раскладываются в бит-реверсном порядке, чтобы корни каждого узла были
+    /// разбросаны по всему отрезку: деление на многочлен с кучными корнями плохо обусловлено
+    struct SubproductTree {
+        explicit SubproductTree(const std::vector<T> &source) : size(source.size()), order(size) {
+            for (size_t i = 0; i < size; ++i) order[i] = i;
+            if constexpr (std::totally_ordered<T>) {
+                std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return source[a] < source[b]; });
+            }
 
+            std::vector<size_t> ranks(size);
+            for (size_t i = 0; i < size; ++i) ranks[i] = i;
+            size_t bits = std::bit_width(size);
+            auto reversed = [bits](size_t value) {
+                size_t result = 0;
+                for (size_t k = 0; k < bits; ++k) result |= ((value >> k) & 1) << (bits - 1 - k);
+                return result;
+            };
+            std::sort(ranks.begin(), ranks.end(), [&](size_t a, size_t b) { return reversed(a) < reversed(b); });
+
+            std::vector<size_t> sorted = order;
+            for (size_t i = 0; i < size; ++i) order[i] = sorted[ranks[i]];
+            for (size_t index: order) points.push_back(source[index]);
+
+            levels.emplace_back();
+            for (const T &x: points) levels.back().push_back(BasicPolynomial({-x, T(1)}));
+
+            while (levels.back().size() > 1) {
+                const std::vector<BasicPolynomial> &below = levels.back();
+                std::vector<BasicPolynomial> above;
+                for (size_t j = 0; j + 1 < below.size(); j += 2) above.push_back(below[j] * below[j + 1]);
+                if (below.size() % 2 == 1) above.push_back(below.back());
+                levels.push_back(std::move(above));
+            }
+        }
 
-class Polynomial {
-public:
+        [[nodiscard]] const BasicPolynomial &root() const {
+            return levels.back()[0];
+        }
 
-    Polynomial() : _koefs({0.0}) {};
+        /// out[i] = P(source[i]), в исходном порядке точек
+        void evaluate(const BasicPolynomial &poly, T *out) const {
+            std::vector<T> values(size);
+            descend(poly.divide(root()).second, levels.size() - 1, 0, values.data());
+            for (size_t i = 0; i < size; ++i) out[order[i]] = values[i];
+        }
 
-    explicit Polynomial(const std::vector<double> &vec) : _koefs(vec) {
-        if (vec.empty()) { _koefs = {0.0}; };
-    }
+        /// remainder = P mod узел (level, index)
+        void descend(const BasicPolynomial &remainder, size_t level, size_t index, T *out) const {
+            size_t first = index << level, count = std::min(size - first, size_t(1) << level);
+            if (count <= subproduct_leaf_size || level == 0) {
+                remainder.evaluate(points.data() + first, count, out + first);
+                return;
+            }
 
-    friend std::ostream &operator<<(std::ostream &out, const Polynomial &poly) {
-        for (size_t i = poly._koefs.size() - 1; i > 0; --i) {
-            out << poly._koefs[i] << "x^" << i << " + ";
+            const std::vector<BasicPolynomial> &below = levels[level - 1];
+            for (size_t child = 2 * index; child < std::min(2 * index + 2, below.size()); ++child) {
+                descend(remainder.divide(below[child]).second, level - 1, child, out);
+            }
         }
 
-        out << poly._koefs[0];
+        /// sum c_i prod_{j != i} (x - x_j) по точкам узла (level, index), c в исходном порядке точек
+        [[nodiscard]] BasicPolynomial combine(const std::vector<T> &c, size_t level, size_t index) const {
+            if (level == 0) return BasicPolynomial({c[order[index]]});
 
+            const std::vector<BasicPolynomial> &below = levels[level - 1];
+            if (2 * index + 1 == below.size()) return combine(c, level - 1, 2 * index);
+            return combine(c, level - 1, 2 * index) * below[2 * index + 1] +
+                   combine(c, level - 1, 2 * index + 1) * below[2 * index];
+        }
 
-        return out;
+        size_t size;
+        std::vector<size_t> order; // points[i] = source[order[i]]
+        std::vector<T> points;
+        std::vector<std::vector<BasicPolynomial>> levels;
+    };
+
+    /// koefs[0, size) от q при size <= composition_threshold * 2^level; powers[0] = q,
+    /// powers[k] = q^(composition_threshold * 2^(k - 1))
+    static BasicPolynomial compose_block(const T *koefs, size_t size, const std::vector<BasicPolynomial> &powers,
+                                         size_t level) {
+        if (level == 0) {
+            BasicPolynomial result({koefs[size - 1]});
+            for (size_t k = size - 1; k-- > 0;) {
+                result *= powers[0];
+                result._koefs[0] += koefs[k];
+            }
+            return result;
+        }
+
+        size_t half = composition_threshold << (level - 1);
+        if (size <= half) return compose_block(koefs, size, powers, level - 1);
+        BasicPolynomial result = compose_block(koefs + half, size - half, powers, level - 1);
+        result *= powers[level];
+        result += compose_block(koefs, half, powers, level - 1);
+        return result;
     }
 
-    double operator()(const double x) const {
-        double _x = 1;
-        double res = 0.0;
+    /// Разделённые разности, затем форма Ньютона c_0 + (x - x_0)(c_1 + (x - x_1)(...)) раскрывается Горнером
+    static BasicPolynomial interpolate_newton(const std::vector<T> &xs, const std::vector<T> &ys) {
+        size_t n = xs.size();
+        std::vector<T> differences = ys;
+        for (size_t j = 1; j < n; ++j) {
+            for (size_t i = n - 1; i >= j; --i) {
+                T step = xs[i] - xs[i - j];
+                if (step == T()) throw std::invalid_argument("Polynomial interpolation points repeat");
+                differences[i] = (differences[i] - differences[i - 1]) / step;
+            }
+        }
 
-        for (double koef: _koefs) {
-            res += koef * _x;
-            _x *= x;
+        BasicPolynomial result;
+        result._koefs.resize(n);
+        T *koefs = result._koefs.data();
+        koefs[0] = differences[n - 1];
+        for (size_t k = n - 1, degree = 0; k-- > 0; ++degree) {
+            for (size_t i = degree + 1; i-- > 0;) {
+                koefs[i + 1] += koefs[i];
+                koefs[i] *= -xs[k];
+            }
+            koefs[0] += differences[k];
         }
+        result.reduce();
+        return result;
+    }
 
-        return res;
+    static bool is_integer(const double *values, size_t size) {
+        return std::all_of(values, values + size, [](double value) { return std::nearbyint(value) == value; });
     }
 
-    static std::vector<double>
-    apply_addictive(double(*operation)(double, double), const std::vector<double> &lhs,
-                    const std::vector<double> &rhs) {
-        size_t lhs_size = lhs.size();
-        size_t rhs_size = rhs.size();
+    /// Длина без старших нулевых коэффициентов, 0 для нулевого многочлена
+    static size_t significant_size(const Storage &vec) {
+        size_t size = vec.size();
+        while (size > 0 && vec[size - 1] == T()) --size;
+        return size;
+    }
 
+    static BasicPolynomial reduced(BasicPolynomial poly) {
+        poly.reduce();
+        return poly;
+    }
 
-        std::vector<double> result;
-        size_t common;
+    static double max_abs(const double *values, size_t size) {
+        double result = 0;
+        for (size_t i = 0; i < size; ++i) result = std::max(result, std::abs(values[i]));
+        return result;
+    }
 
-        if (lhs_size >= rhs_size) {
-            common = rhs_size;
-            result.resize(lhs_size);
-            std::copy(
-                    lhs.begin() + common,  // NOLINT(*-narrowing-conversions)
-                    lhs.end(),
-                    result.begin() + common  // NOLINT(*-narrowing-conversions)
-            );
+    // Обязательно длина хотя бы 1
+    // _koefs[i] соответствует коэффициенту при x^i
+    Storage _koefs;
+};
 
-        } else {
-            common = lhs_size;
-            result.resize(rhs_size);
-            std::copy(
-                    rhs.begin() + common,  // NOLINT(*-narrowing-conversions)
-                    rhs.end(),
-                    result.begin() + common  // NOLINT(*-narrowing-conversions)
-            );
-        }
+using Polynomial = BasicPolynomial<double>;
 
-        for (size_t i = 0; i < common; ++i) {
-            result[i] = operation(lhs[i], rhs[i]);
+/// Разреженный многочлен: только ненулевые члены по возрастанию степени. x^1000000 + 1 занимает два члена,
+/// сложение, умножение, производная и сдвиг работают за время от числа членов, а не от степени
+class SparsePolynomial {
+public:
+    SparsePolynomial() = default;
+
+    /// Члены в любом порядке, одинаковые степени складываются, нули отбрасываются
+    explicit SparsePolynomial(std::vector<Monom> monoms) : _monoms(std::move(monoms)) {
+        std::sort(_monoms.begin(), _monoms.end(), [](const Monom &a, const Monom &b) { return a.degree < b.degree; });
+        size_t size = 0;
+        for (size_t i = 0; i < _monoms.size(); ++i) {
+            if (size > 0 && _monoms[size - 1].degree == _monoms[i].degree) {
+                _monoms[size - 1].koef += _monoms[i].koef;
+            } else {
+                if (size > 0 && _monoms[size - 1].koef == 0.0) --size;
+                _monoms[size++] = _monoms[i];
+            }
         }
+        if (size > 0 && _monoms[size - 1].koef == 0.0) --size;
+        _monoms.resize(size);
+    }
 
-//        _reduce_vector(result);
+    explicit SparsePolynomial(const Polynomial &dense)
+            : _monoms(Polynomial::to_monoms(dense._koefs.data(), dense._koefs.size())) {}
 
+    [[nodiscard]] Polynomial to_dense() const {
+        Polynomial result;
+        result._koefs.resize(getDegree() + 1);
+        for (const Monom &monom: _monoms) result._koefs[monom.degree] = monom.koef;
         return result;
     }
 
-    Polynomial operator+(const Polynomial &other) const {
-        return Polynomial(apply_addictive(plus, this->_koefs, other._koefs));
+    /// Доля ненулевых коэффициентов плотного многочлена
+    static double density(const Polynomial &dense) {
+        return static_cast<double>(Polynomial::to_monoms(dense._koefs.data(), dense._koefs.size()).size()) /
+               static_cast<double>(dense._koefs.size());
+    }
+
+    /// true, если многочлену выгоднее разреженное представление - по тому же порогу
+    /// Polynomial::sparse_density_threshold, по которому умножение Polynomial переходит на разреженное
+    static bool prefers_sparse(const Polynomial &dense) {
+        return Polynomial::is_sparse(dense._koefs.data(), dense._koefs.size());
+    }
+
+    [[nodiscard]] const std::vector<Monom> &monoms() const {
+        return _monoms;
+    }
+
+    [[nodiscard]] uint64_t getDegree() const {
+        return _monoms.empty() ? 0 : _monoms.back().degree;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const SparsePolynomial &poly) {
+        if (poly._monoms.empty()) return out << 0;
+        for (size_t i = poly._monoms.size(); i-- > 0;) {
+            out << poly._monoms[i].koef;
+            if (poly._monoms[i].degree != 0) out << "x^" << poly._monoms[i].degree;
+            if (i != 0) out << " + ";
+        }
+        return out;
     }
 
-    Polynomial operator-(const Polynomial &other) const {
-        return Polynomial(apply_addictive(minus, this->_koefs, other._koefs));
+    /// Горнер по разрывам между степенями: x^gap возводится в степень двоичным методом, O(t log deg)
+    double operator()(const double x) const {
+        double res = 0.0;
+        for (size_t i = _monoms.size(); i-- > 0;) {
+            uint64_t next = i == 0 ? 0 : _monoms[i - 1].degree;
+            res = (res + _monoms[i].koef) * power(x, _monoms[i].degree - next);
+        }
+        return res;
     }
 
-    Polynomial operator+=(const Polynomial &other) {
-        _koefs = apply_addictive(plus, this->_koefs, other._koefs);
+    bool operator==(const SparsePolynomial &other) const = default;
+
+    SparsePolynomial &operator+=(const SparsePolynomial &other) {
+        _monoms = merge(_monoms, other._monoms, 1.0);
         return *this;
     }
 
-    Polynomial operator-=(const Polynomial &other) {
-        _koefs = apply_addictive(minus, this->_koefs, other._koefs);
+    SparsePolynomial &operator-=(const SparsePolynomial &other) {
+        _monoms = merge(_monoms, other._monoms, -1.0);
         return *this;
     }
 
-    Polynomial operator-() const {
-        std::vector<double> result(_koefs.size());
-        for (size_t i = 0; i < _koefs.size(); ++i) {
-            result[i] = -_koefs[i];
+    friend SparsePolynomial operator+(SparsePolynomial lhs, const SparsePolynomial &rhs) {
+        lhs += rhs;
+        return lhs;
+    }
+
+    friend SparsePolynomial operator-(SparsePolynomial lhs, const SparsePolynomial &rhs) {
+        lhs -= rhs;
+        return lhs;
+    }
+
+    SparsePolynomial operator-() const {
+        SparsePolynomial result = *this;
+        for (Monom &monom: result._monoms) monom.koef = -monom.koef;
+        return result;
+    }
+
+    SparsePolynomial operator*(const SparsePolynomial &other) const {
+        SparsePolynomial result;
+        result._monoms = multiply_monoms(_monoms, other._monoms);
+        return result;
+    }
+
+    SparsePolynomial &operator*=(const SparsePolynomial &other) {
+        _monoms = multiply_monoms(_monoms, other._monoms);
+        return *this;
+    }
+
+    [[nodiscard]] SparsePolynomial multiply_monom(const uint64_t degree) const {
+        SparsePolynomial result = *this;
+        for (Monom &monom: result._monoms) monom.degree += degree;
+        return result;
+    }
+
+    [[nodiscard]] SparsePolynomial derivative() const {
+        SparsePolynomial result;
+        for (const Monom &monom: _monoms) {
+            if (monom.degree != 0) result._monoms.push_back({monom.degree - 1, static_cast<double>(monom.degree) * monom.koef});
         }
-        return Polynomial(result);
+        return result;
     }
 
-    Polynomial operator*(const Polynomial &other) const {
-        std::vector<double> result(_koefs.size() + other._koefs.size() - 1);
+private:
+    static double power(double x, uint64_t degree) {
+        double result = 1.0;
+        for (; degree != 0; degree >>= 1) {
+            if ((degree & 1) != 0) result *= x;
+            if (degree > 1) x *= x;
+        }
+        return result;
+    }
 
-        for (size_t i = 0; i < _koefs.size(); ++i) {
-            for (size_t j = 0; j < other._koefs.size(); ++j) {
-                result[i + j] += _koefs[i] * other._koefs[j];
+    /// lhs + sign * rhs слиянием двух упорядоченных списков
+    static std::vector<Monom> merge(const std::vector<Monom> &lhs, const std::vector<Monom> &rhs, double sign) {
+        std::vector<Monom> result;
+        result.reserve(lhs.size() + rhs.size());
+        size_t i = 0, j = 0;
+        while (i < lhs.size() || j < rhs.size()) {
+            if (j == rhs.size() || (i < lhs.size() && lhs[i].degree < rhs[j].degree)) {
+                result.push_back(lhs[i++]);
+            } else if (i == lhs.size() || rhs[j].degree < lhs[i].degree) {
+                result.push_back({rhs[j].degree, sign * rhs[j].koef});
+                ++j;
+            } else {
+                double koef = lhs[i].koef + sign * rhs[j].koef;
+                if (koef != 0.0) result.push_back({lhs[i].degree, koef});
+                ++i;
+                ++j;
             }
         }
+        return result;
+    }
+
+    // Члены с ненулевыми коэффициентами по возрастанию степени
+    std::vector<Monom> _monoms;
+};
+
+/// Многочлен степени не выше N с коэффициентами в std::array: всё constexpr, вычисление полностью
+/// разворачивается при компиляции и встраивается в вызывающий код, так что приближение в цикле - это N умножений-сложений
+template<size_t N>
+class FixedPolynomial {
+public:
+    constexpr FixedPolynomial() = default;
 
+    constexpr explicit FixedPolynomial(const std::array<double, N + 1> &koefs) : _koefs(koefs) {}
 
-        Polynomial poly = Polynomial(result);
-        poly.reduce(); // при умножении на 0 может быть такое
-        return poly;
+    template<typename... Koefs> requires (sizeof...(Koefs) == N + 1 && (std::convertible_to<Koefs, double> && ...))
+    constexpr FixedPolynomial(Koefs... koefs) : _koefs{static_cast<double>(koefs)...} {}
+
+    /// Из обычного многочлена; кидает std::invalid_argument, если его степень больше N
+    explicit FixedPolynomial(const Polynomial &poly) {
+        if (poly.getDegree() > N) throw std::invalid_argument("FixedPolynomial degree is too small");
+        for (size_t i = 0; i <= poly.getDegree(); ++i) _koefs[i] = poly[i];
     }
 
-    Polynomial operator*=(const Polynomial &other) {
-        *this = *this * other;
-        return *this;
+    [[nodiscard]] Polynomial to_polynomial() const {
+        Polynomial result(std::vector<double>(_koefs.begin(), _koefs.end()));
+        result.reduce();
+        return result;
     }
 
-    Polynomial multiply_monom(const unsigned int degree) const {
-        std::vector<double> result(_koefs.size() + degree);
-        for (size_t i = 0; i < _koefs.size(); ++i) {
-            result[i + degree] = _koefs[i];
-        }
+    constexpr double operator[](size_t i) const {
+        return _koefs[i];
+    }
 
-        return Polynomial(result);
+    /// Горнер, развёрнутый в цепочку из N шагов
+    constexpr double operator()(double x) const {
+        return horner(x, std::make_index_sequence<N>());
     }
 
-    bool operator==(const Polynomial &other) const {
-        if (_koefs.size() != other._koefs.size()) return false;
+    /// Схема Эстрина: пары коэффициентов складываются независимо, затем с x^2, x^4, ...
+    /// Длина зависимой цепочки log2(N) вместо N, что выгоднее Горнера для одной точки большой степени
+    constexpr double estrin(double x) const {
+        std::array<double, std::max<size_t>(1, std::bit_width(N))> powers{x};
+        for (size_t k = 1; k < powers.size(); ++k) powers[k] = powers[k - 1] * powers[k - 1];
+        return estrin_part<0, N + 1>(powers);
+    }
 
-        for (size_t i = 0; i < _koefs.size(); ++i) {
-            if (_koefs[i] != other._koefs[i]) return false;
+    /// out[i] = P(xs[i]); тело встраивается и векторизуется по точкам
+    void evaluate(const double *xs, size_t count, double *out) const {
+        for (size_t i = 0; i < count; ++i) out[i] = (*this)(xs[i]);
+    }
+
+    constexpr auto derivative() const {
+        if constexpr (N == 0) {
+            return FixedPolynomial<0>();
+        } else {
+            FixedPolynomial<N - 1> result;
+            for (size_t i = 1; i <= N; ++i) result._koefs[i - 1] = static_cast<double>(i) * _koefs[i];
+            return result;
         }
+    }
 
-        return true;
+    template<size_t M>
+    constexpr FixedPolynomial<N + M> operator*(const FixedPolynomial<M> &other) const {
+        FixedPolynomial<N + M> result;
+        for (size_t i = 0; i <= N; ++i) {
+            for (size_t j = 0; j <= M; ++j) result._koefs[i + j] += _koefs[i] * other._koefs[j];
+        }
+        return result;
+    }
+
+    template<size_t M>
+    constexpr FixedPolynomial<std::max(N, M)> operator+(const FixedPolynomial<M> &other) const {
+        FixedPolynomial<std::max(N, M)> result;
+        for (size_t i = 0; i <= N; ++i) result._koefs[i] += _koefs[i];
+        for (size_t i = 0; i <= M; ++i) result._koefs[i] += other._koefs[i];
+        return result;
     }
 
-    Polynomial derivative() const {
-        if (_koefs.size() == 1) return Polynomial({0});
+    template<size_t M>
+    constexpr FixedPolynomial<std::max(N, M)> operator-(const FixedPolynomial<M> &other) const {
+        FixedPolynomial<std::max(N, M)> result;
+        for (size_t i = 0; i <= N; ++i) result._koefs[i] += _koefs[i];
+        for (size_t i = 0; i <= M; ++i) result._koefs[i] -= other._koefs[i];
+        return result;
+    }
 
-        std::vector<double> result(_koefs.size() - 1);
+    constexpr bool operator==(const FixedPolynomial &other) const = default;
 
-        for (size_t i = 1; i < _koefs.size(); ++i) {
-            result[i - 1] = static_cast<double>(i) * _koefs[i];
+private:
+    template<size_t> friend
+    class FixedPolynomial;
+
+    template<size_t... I>
+    constexpr double horner(double x, std::index_sequence<I...>) const {
+        double result = _koefs[N];
+        ((result = result * x + _koefs[N - 1 - I]), ...);
+        return result;
+    }
+
+    /// Коэффициенты [Begin, Begin + Count): младшая половина + x^half * старшая, half - степень двойки
+    template<size_t Begin, size_t Count, size_t Levels>
+    constexpr double estrin_part(const std::array<double, Levels> &powers) const {
+        if constexpr (Count == 1) {
+            return _koefs[Begin];
+        } else {
+            constexpr size_t half = std::bit_floor(Count - 1);
+            return estrin_part<Begin, half>(powers) +
+                   powers[std::countr_zero(half)] * estrin_part<Begin + half, Count - half>(powers);
+        }
+    }
+
+    // _koefs[i] соответствует коэффициенту при x^i
+    std::array<double, N + 1> _koefs{};
+};
+
+template<typename... Koefs>
+FixedPolynomial(Koefs...) -> FixedPolynomial<sizeof...(Koefs) - 1>;
+
+/// Многочленное приближение функции и достигнутая ошибка max |f - poly| на отрезке
+struct Approximation {
+    Polynomial poly;
+    double error;
+};
+
+/// Приближение функций многочленами на отрезке [a, b]. Внутри всё считается в переменной t = (2x - a - b) / (b - a)
+/// в базисе Чебышёва и только в конце переводится в обычный Polynomial от x
+class PolynomialApproximation {
+public:
+    /// Число точек сетки, по которой ищутся экстремумы ошибки (сгущаются к концам отрезка)
+    inline static size_t grid_size = 4000;
+
+    /// Многочлен наименьшей степени (не выше max_degree) с ошибкой не больше target_error: для каждой степени строится
+    /// интерполянт по узлам Чебышёва, а если он близок к цели - уточняется обменом Ремеза до наилучшего равномерного.
+    /// Если цель недостижима, возвращается приближение степени max_degree с его ошибкой
+    template<typename Function>
+    static Approximation build(Function f, double a, double b, double target_error, size_t max_degree = 40) {
+        Approximation best{};
+        for (size_t degree = 0; degree <= max_degree; ++degree) {
+            best = chebyshev(f, a, b, degree);
+            // интерполянт по Чебышёву хуже наилучшего не больше чем в несколько раз
+            if (best.error > 8 * target_error) continue;
+
+            Approximation minimax = remez(f, a, b, degree);
+            if (minimax.error < best.error) best = minimax;
+            if (best.error <= target_error) return best;
         }
+        return best;
+    }
 
-        return Polynomial(result);
+    /// Интерполянт степени degree по узлам Чебышёва
+    template<typename Function>
+    static Approximation chebyshev(Function f, double a, double b, size_t degree) {
+        size_t count = degree + 1;
+        std::vector<double> values(count), koefs(count);
+        for (size_t j = 0; j < count; ++j) values[j] = f(to_x(std::cos(node_angle(j, count)), a, b));
+        for (size_t k = 0; k < count; ++k) {
+            double sum = 0;
+            for (size_t j = 0; j < count; ++j) {
+                sum += values[j] * std::cos(static_cast<double>(k) * node_angle(j, count));
+            }
+            koefs[k] = (k == 0 ? 1.0 : 2.0) * sum / static_cast<double>(count);
+        }
+        return finish(f, a, b, koefs);
     }
 
-    static void _reduce_vector(std::vector<double> &vec) {
-        size_t new_size = vec.size();
-        for (size_t i = new_size - 1; i > 0; --i) { // обязательно оставляем нулевой коэффициент
-            if (vec[i] != 0.0) {
-                new_size = i + 1;
-                break;
+    /// Наилучшее равномерное приближение степени degree обменом Ремеза: на опорных точках решается система
+    /// p(t_i) + (-1)^i E = f(t_i), затем опорные точки заменяются экстремумами ошибки с чередующимися знаками,
+    /// пока модули ошибки в них не сравняются
+    template<typename Function>
+    static Approximation remez(Function f, double a, double b, size_t degree, size_t max_iterations = 50) {
+        size_t count = degree + 2;
+        std::vector<double> reference(count);
+        for (size_t i = 0; i < count; ++i) {
+            reference[i] = -std::cos(std::numbers::pi * static_cast<double>(i) / static_cast<double>(count - 1));
+        }
+
+        // на уровне ошибок округления знаки ошибки случайны, поэтому запоминается лучшая итерация
+        std::vector<double> koefs(degree + 1), best;
+        double best_error = std::numeric_limits<double>::max();
+        for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
+            // неизвестные: коэффициенты Чебышёва c_0..c_n и уровень E
+            std::vector<double> matrix(count * count), rhs(count);
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t k = 0; k <= degree; ++k) matrix[i * count + k] = chebyshev_t(k, reference[i]);
+                matrix[i * count + degree + 1] = i % 2 == 0 ? 1.0 : -1.0;
+                rhs[i] = f(to_x(reference[i], a, b));
+            }
+            if (!solve(matrix, rhs, count)) break;
+            std::copy_n(rhs.begin(), degree + 1, koefs.begin());
+
+            auto error = [&](double t) { return f(to_x(t, a, b)) - chebyshev_sum(koefs, t); };
+            double grid_error = 0;
+            std::vector<double> next = alternating_extrema(error, count, grid_error);
+            if (grid_error < best_error) {
+                best_error = grid_error;
+                best = koefs;
             }
+            if (next.size() != count) break;
+            reference = next;
+
+            double smallest = std::numeric_limits<double>::max(), largest = 0;
+            for (double point: reference) {
+                smallest = std::min(smallest, std::abs(error(point)));
+                largest = std::max(largest, std::abs(error(point)));
+            }
+            if (largest - smallest <= 1e-6 * largest) break;
         }
+        return finish(f, a, b, best.empty() ? koefs : best);
+    }
 
-        vec.resize(new_size);
+private:
+    static double node_angle(size_t j, size_t count) {
+        return std::numbers::pi * (static_cast<double>(j) + 0.5) / static_cast<double>(count);
     }
 
-    /// Отбрасывает все старшие степени с нулями
-    void reduce() {
-        _reduce_vector(_koefs);
+    static double to_x(double t, double a, double b) {
+        return (a + b) / 2 + (b - a) / 2 * t;
     }
 
-    size_t getDegree() const {
-        return _koefs.size() - 1;
+    static double chebyshev_t(size_t k, double t) {
+        return std::cos(static_cast<double>(k) * std::acos(std::clamp(t, -1.0, 1.0)));
+    }
+
+    /// sum c_k T_k(t) по Кленшоу
+    static double chebyshev_sum(const std::vector<double> &koefs, double t) {
+        double b1 = 0, b2 = 0;
+        for (size_t k = koefs.size(); k-- > 1;) {
+            double b0 = 2 * t * b1 - b2 + koefs[k];
+            b2 = b1;
+            b1 = b0;
+        }
+        return t * b1 - b2 + koefs[0];
     }
 
-    /// Возвращает результат деления столбиком на divisor в виде (результат, остаток)
-    std::pair<Polynomial, Polynomial> divide(const Polynomial &divisor) const {
-        size_t self_degree = getDegree(), divider_degree = divisor.getDegree();
+    /// Точки сетки со знакочередующейся ошибкой: в каждом участке постоянного знака берётся максимум |e|,
+    /// он уточняется золотым сечением между соседними узлами сетки; лишние участки отбрасываются с краёв.
+    /// В max_error записывается максимум |e| по сетке
+    template<typename Error>
+    static std::vector<double> alternating_extrema(Error error, size_t count, double &max_error) {
+        std::vector<double> grid(grid_size);
+        for (size_t i = 0; i < grid_size; ++i) {
+            grid[i] = -std::cos(std::numbers::pi * static_cast<double>(i) / static_cast<double>(grid_size - 1));
+        }
 
-        if (divider_degree == 0) {
-            std::vector<double> quotient(_koefs.size());
-            double k = divisor._koefs[0];
-            for (size_t i = 0; i < _koefs.size(); ++i) quotient[i] = _koefs[i] / k;
-            return std::make_pair(Polynomial(quotient), Polynomial());
+        std::vector<size_t> extrema;
+        std::vector<double> values(grid_size);
+        for (size_t i = 0; i < grid_size; ++i) {
+            values[i] = error(grid[i]);
+            max_error = std::max(max_error, std::abs(values[i]));
+        }
+        for (size_t i = 0; i < grid_size; ++i) {
+            bool same_sign = !extrema.empty() && (values[i] >= 0) == (values[extrema.back()] >= 0);
+            if (!same_sign) {
+                extrema.push_back(i);
+            } else if (std::abs(values[i]) > std::abs(values[extrema.back()])) {
+                extrema.back() = i;
+            }
+        }
+        while (extrema.size() > count) {
+            if (std::abs(values[extrema.front()]) < std::abs(values[extrema.back()])) {
+                extrema.erase(extrema.begin());
+            } else {
+                extrema.pop_back();
+            }
         }
 
-        if (self_degree < divider_degree) return std::make_pair(Polynomial(), *this);
+        std::vector<double> result;
+        for (size_t index: extrema) {
+            double left = grid[index == 0 ? 0 : index - 1], right = grid[std::min(index + 1, grid_size - 1)];
+            double sign = values[index] >= 0 ? 1 : -1;
+            for (int step = 0; step < 40; ++step) {
+                double m1 = right - (right - left) * 0.618033988749895, m2 = left + (right - left) * 0.618033988749895;
+                if (sign * error(m1) < sign * error(m2)) {
+                    left = m1;
+                } else {
+                    right = m2;
+                }
+            }
+            double refined = (left + right) / 2;
+            result.push_back(sign * error(refined) > sign * values[index] ? refined : grid[index]);
+        }
+        return result;
+    }
 
-        std::vector<double> quotient(self_degree - divider_degree + 1);
-        Polynomial self_copy = *this;
-        double k;
-        for (size_t shift = 0; shift <= self_degree - divider_degree; ++shift) {
-            k = self_copy._koefs[self_copy._koefs.size() - 1 - shift] / divisor._koefs[divisor._koefs.size() - 1];
-            quotient[self_degree - divider_degree - shift] = k;
-//            std::cout << self_copy
-//                      << " - (" << self_degree - divider_degree - shift << ") "
-//                      << divisor.multiply_monom(self_degree - divider_degree - shift)
-//                      << " = ";
-            self_copy -= divisor.multiply_monom(self_degree - divider_degree - shift);
-//            std::cout << self_copy << std::endl;
+    /// Гаусс с выбором ведущего элемента, решение записывается в rhs
+    static bool solve(std::vector<double> &matrix, std::vector<double> &rhs, size_t size) {
+        for (size_t column = 0; column < size; ++column) {
+            size_t pivot = column;
+            for (size_t i = column + 1; i < size; ++i) {
+                if (std::abs(matrix[i * size + column]) > std::abs(matrix[pivot * size + column])) pivot = i;
+            }
+            if (matrix[pivot * size + column] == 0.0) return false;
+            if (pivot != column) {
+                std::swap_ranges(matrix.begin() + pivot * size, matrix.begin() + (pivot + 1) * size, // NOLINT(*-narrowing-conversions)
+                                 matrix.begin() + column * size); // NOLINT(*-narrowing-conversions)
+                std::swap(rhs[pivot], rhs[column]);
+            }
+            for (size_t i = column + 1; i < size; ++i) {
+                double factor = matrix[i * size + column] / matrix[column * size + column];
+                for (size_t j = column; j < size; ++j) matrix[i * size + j] -= factor * matrix[column * size + j];
+                rhs[i] -= factor * rhs[column];
+            }
         }
-//        std::cout << self_copy << std::endl;
+        for (size_t i = size; i-- > 0;) {
+            for (size_t j = i + 1; j < size; ++j) rhs[i] -= matrix[i * size + j] * rhs[j];
+            rhs[i] /= matrix[i * size + i];
+        }
+        return true;
+    }
 
-        self_copy.reduce();
+    /// Переводит sum c_k T_k(t) в Polynomial от x и меряет ошибку по сетке
+    template<typename Function>
+    static Approximation finish(Function f, double a, double b, const std::vector<double> &koefs) {
+        // t = (2x - a - b) / (b - a), T_{k+1} = 2 t T_k - T_{k-1}
+        Polynomial t = {-(a + b) / (b - a), 2 / (b - a)}, two_t = t + t;
+        Polynomial previous = {1}, current = t, result = {koefs[0]};
+        for (size_t k = 1; k < koefs.size(); ++k) {
+            result += current * Polynomial({koefs[k]});
+            Polynomial next = two_t * current - previous;
+            previous = std::move(current);
+            current = std::move(next);
+        }
 
-        Polynomial q = Polynomial(quotient);
-        q.reduce();
+        double error = 0;
+        for (size_t i = 0; i < grid_size; ++i) {
+            double x = to_x(-std::cos(std::numbers::pi * static_cast<double>(i) / static_cast<double>(grid_size - 1)), a, b);
+            error = std::max(error, std::abs(f(x) - result(x)));
+        }
+        return {result, error};
+    }
+};
 
-        return std::make_pair(q, self_copy);
+/// Сводка прогона приближения против эталонной функции. Точки, где эталон не конечен, пропускаются;
+/// относительная ошибка считается только там, где эталон не ноль. Если приближение не конечно при конечном эталоне,
+/// точка считается в non_finite, максимумы ошибок становятся бесконечными (ulp - наибольшим uint64), worst_x - первая
+/// такая точка, а средние считаются по остальным точкам. Время - суммарное по потокам на одну точку
+struct AccuracyReport {
+    size_t points = 0, skipped = 0, non_finite = 0;
+    double max_abs_error = 0, mean_abs_error = 0, max_rel_error = 0, mean_rel_error = 0;
+    uint64_t max_ulp_error = 0;
+    double mean_ulp_error = 0;
+    double worst_x = 0;
+    double approximant_ns = 0, reference_ns = 0;
+
+    friend std::ostream &operator<<(std::ostream &out, const AccuracyReport &report) {
+        return out << "points " << report.points << " (skipped " << report.skipped
+                   << ", non-finite " << report.non_finite << ")"
+                   << " | abs max " << report.max_abs_error << " mean " << report.mean_abs_error
+                   << " | rel max " << report.max_rel_error << " mean " << report.mean_rel_error
+                   << " | ulp max " << report.max_ulp_error << " mean " << report.mean_ulp_error
+                   << " | worst x " << report.worst_x
+                   << " | ns/eval " << report.approximant_ns << " vs " << report.reference_ns;
+    }
+};
 
+/// Прогон приближения по равномерной сетке из миллионов точек: отрезок делится между потоками, каждый поток идёт
+/// блоками по block_size точек, считая приближение пакетно через evaluate(xs, count, out) (подходят и Polynomial,
+/// и FixedPolynomial), а эталон - поточечно
+class AccuracySweep {
+public:
+    inline static size_t block_size = 1 << 12;
+
+    template<typename Approximant, typename Reference>
+    static AccuracyReport run(const Approximant &approximant, Reference reference, double a, double b,
+                              size_t points = 1 << 22) {
+        size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                                              points / block_size));
+        std::vector<Partial> partials(threads);
+        size_t chunk = (points + threads - 1) / threads;
+        double step = points > 1 ? (b - a) / static_cast<double>(points - 1) : 0;
+
+        auto work = [&](size_t index) {
+            size_t begin = index * chunk, end = std::min(points, begin + chunk);
+            sweep(approximant, reference, a, step, begin, end, partials[index]);
+        };
+        std::vector<std::thread> workers;
+        for (size_t index = 1; index < threads; ++index) workers.emplace_back(work, index);
+        work(0);
+        for (auto &worker: workers) worker.join();
+
+        Partial total;
+        for (const Partial &partial: partials) total.merge(partial);
+
+        AccuracyReport report;
+        report.points = points;
+        report.skipped = points - total.counted - total.non_finite;
+        report.non_finite = total.non_finite;
+        report.max_abs_error = total.max_abs;
+        report.max_rel_error = total.max_rel;
+        report.max_ulp_error = total.max_ulp;
+        report.worst_x = total.worst_x;
+        if (total.counted > 0) {
+            auto counted = static_cast<double>(total.counted);
+            report.mean_abs_error = total.sum_abs / counted;
+            report.mean_ulp_error = total.sum_ulp / counted;
+        }
+        if (total.rel_counted > 0) report.mean_rel_error = total.sum_rel / static_cast<double>(total.rel_counted);
+        if (points > 0) {
+            report.approximant_ns = total.approximant_ns / static_cast<double>(points);
+            report.reference_ns = total.reference_ns / static_cast<double>(points);
+        }
+        return report;
     }
 
+    /// Число представимых double между a и b; с NaN - наибольшее uint64
+    static uint64_t ulp_distance(double a, double b) {
+        if (std::isnan(a) || std::isnan(b)) return std::numeric_limits<uint64_t>::max();
+        auto key = [](double value) {
+            auto bits = std::bit_cast<int64_t>(value);
+            // отрицательные числа в дополнительном коде идут в обратном порядке
+            return bits < 0 ? std::numeric_limits<int64_t>::min() - bits : bits;
+        };
+        int64_t lhs = key(a), rhs = key(b);
+        return lhs > rhs ? static_cast<uint64_t>(lhs) - static_cast<uint64_t>(rhs)
+                         : static_cast<uint64_t>(rhs) - static_cast<uint64_t>(lhs);
+    }
 
 private:
-    // Обязательно длина хотя бы 1
-    // _koefs[i] соответствует коэффициенту при x^i
-    std::vector<double> _koefs;
+    struct Partial {
+        size_t counted = 0, rel_counted = 0, non_finite = 0;
+        double max_abs = 0, sum_abs = 0, max_rel = 0, sum_rel = 0, sum_ulp = 0, worst_x = 0;
+        uint64_t max_ulp = 0;
+        double approximant_ns = 0, reference_ns = 0;
+
+        void merge(const Partial &other) {
+            if (other.max_abs > max_abs || counted + non_finite == 0) worst_x = other.worst_x;
+            counted += other.counted;
+            non_finite += other.non_finite;
+            rel_counted += other.rel_counted;
+            max_abs = std::max(max_abs, other.max_abs);
+            sum_abs += other.sum_abs;
+            max_rel = std::max(max_rel, other.max_rel);
+            sum_rel += other.sum_rel;
+            max_ulp = std::max(max_ulp, other.max_ulp);
+            sum_ulp += other.sum_ulp;
+            approximant_ns += other.approximant_ns;
+            reference_ns += other.reference_ns;
+        }
+    };
+
+    template<typename Approximant, typename Reference>
+    static void sweep(const Approximant &approximant, Reference &reference, double a, double step, size_t begin,
+                      size_t end, Partial &partial) {
+        using clock = std::chrono::steady_clock;
+        std::vector<double> xs(block_size), approximated(block_size), expected(block_size);
+
+        for (size_t block = begin; block < end; block += block_size) {
+            size_t count = std::min(block_size, end - block);
+            for (size_t i = 0; i < count; ++i) xs[i] = a + step * static_cast<double>(block + i);
+
+            auto start = clock::now();
+            approximant.evaluate(xs.data(), count, approximated.data());
+            auto middle = clock::now();
+            for (size_t i = 0; i < count; ++i) expected[i] = reference(xs[i]);
+            auto finish = clock::now();
+            partial.approximant_ns += std::chrono::duration<double, std::nano>(middle - start).count();
+            partial.reference_ns += std::chrono::duration<double, std::nano>(finish - middle).count();
+
+            for (size_t i = 0; i < count; ++i) {
+                if (!std::isfinite(expected[i])) continue;
+                if (!std::isfinite(approximated[i])) {
+                    // NaN выпал бы из сравнений с максимумами, поэтому такие точки учитываются отдельно
+                    double infinity = std::numeric_limits<double>::infinity();
+                    if (partial.max_abs != infinity) partial.worst_x = xs[i];
+                    ++partial.non_finite;
+                    partial.max_abs = partial.max_rel = infinity;
+                    partial.max_ulp = std::numeric_limits<uint64_t>::max();
+                    continue;
+                }
+                double error = std::abs(approximated[i] - expected[i]);
+                ++partial.counted;
+                partial.sum_abs += error;
+                if (error > partial.max_abs || partial.counted + partial.non_finite == 1) {
+                    partial.max_abs = error;
+                    partial.worst_x = xs[i];
+                }
+                if (expected[i] != 0) {
+                    double relative = error / std::abs(expected[i]);
+                    ++partial.rel_counted;
+                    partial.sum_rel += relative;
+                    partial.max_rel = std::max(partial.max_rel, relative);
+                }
+                uint64_t ulp = ulp_distance(approximated[i], expected[i]);
+                partial.sum_ulp += static_cast<double>(ulp);
+                partial.max_ulp = std::max(partial.max_ulp, ulp);
+            }
+        }
+    }
 };
 
 void test_simple() {
@@ -240,27 +1967,476 @@ void test_simple() {
 
 }
 
-void test_single_poly(const Polynomial &poly, double(*realFunc)(double), const std::string &funcName, double eps) {
-    for (double x = -0.3; x < 0.3; x += 0.01) {
-        double a = poly(x), b = realFunc(x);
-        double delta = a - b, ratio = delta / b;
-        if ((delta > eps) || (ratio > eps)) {
-            std::cout << poly << " ~ " << funcName
-                      << " | x = " << x
-                      << " | poly = " << a
-                      << " | func = " << b
-                      << " | delta " << delta
-                      << " | ratio = " << ratio
-                      << std::endl;
+/// Сравнивает все пути умножения со столбиком на случайных многочленах разной длины
+void test_multiply() {
+    auto naive = [](const std::vector<double> &a, const std::vector<double> &b) {
+        std::vector<double> result(a.size() + b.size() - 1);
+        Polynomial::multiply_naive(a.data(), a.size(), b.data(), b.size(), result.data());
+        return result;
+    };
+    auto fast = [](const std::vector<double> &a, const std::vector<double> &b) {
+        std::vector<double> result(a.size() + b.size() - 1);
+        Polynomial::multiply(a.data(), a.size(), b.data(), b.size(), result.data());
+        return result;
+    };
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> real(-1, 1);
+    std::uniform_int_distribution<int> integer(-1000, 1000);
+
+    for (auto [n, m]: {std::pair<size_t, size_t>{5, 7}, {40, 40}, {100, 37}, {333, 1000}, {600, 600}, {3000, 700}}) {
+        std::vector<double> a(n), b(m), c(n), d(m);
+        for (auto &x: a) x = real(generator);
+        for (auto &x: b) x = real(generator);
+        for (auto &x: c) x = integer(generator);
+        for (auto &x: d) x = integer(generator);
+
+        auto expected = naive(a, b), actual = fast(a, b);
+        for (size_t i = 0; i < expected.size(); ++i) assert(std::abs(expected[i] - actual[i]) < 1e-11);
+
+        // целые коэффициенты и Карацуба, и БПФ перемножают точно
+        assert(naive(c, d) == fast(c, d));
+    }
+
+    // ожидания test_simple на всех путях
+    size_t karatsuba = Polynomial::karatsuba_threshold, fft = Polynomial::fft_threshold;
+    Polynomial p = Polynomial({1, 2}), q = Polynomial({3, 4});
+    Polynomial::karatsuba_threshold = 1;
+    assert(p * q == Polynomial({3, 10, 8}));
+    Polynomial::fft_threshold = 1;
+    assert(p * q == Polynomial({3, 10, 8}));
+    assert(Polynomial({1, 1, 1}) * Polynomial({1, -1}) == Polynomial({1, 0, 0, -1}));
+    Polynomial::karatsuba_threshold = karatsuba;
+    Polynomial::fft_threshold = fft;
+}
+
+void test_evaluate() {
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> real(-1, 1);
+
+    for (size_t degree: {0, 1, 5, 40}) {
+        std::vector<double> koefs(degree + 1);
+        for (auto &k: koefs) k = real(generator);
+        Polynomial poly(koefs);
+
+        // больше порога, чтобы проверить и потоки, и хвост блока
+        std::vector<double> xs(Polynomial::parallel_evaluation_threshold + 13);
+        for (auto &x: xs) x = real(generator);
+        std::vector<double> values = poly.evaluate(xs);
+        for (size_t i = 0; i < xs.size(); ++i) assert(std::abs(values[i] - poly(xs[i])) < 1e-12);
+    }
+
+    Polynomial p = Polynomial({1.0, 2.0});
+    assert(p.evaluate({0.0, 2.0}) == (std::vector<double>{1.0, 5.0}));
+}
+
+void test_multipoint() {
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> real(-1, 1);
+
+    // в double деревья точны только для умеренных n, см. evaluate_multipoint и interpolate
+    for (size_t n: {1, 7, 24, 40, 64}) {
+        std::vector<double> koefs(n);
+        for (auto &k: koefs) k = real(generator);
+        Polynomial poly(koefs);
+
+        // узлы Чебышёва в перемешанном порядке
+        std::vector<double> xs(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs[(i * 11) % n] = std::cos(std::numbers::pi * (static_cast<double>(i) + 0.5) / static_cast<double>(n));
+        }
+
+        std::vector<double> fast = poly.evaluate_multipoint(xs), direct = poly.evaluate(xs);
+        double error = 0;
+        for (size_t i = 0; i < n; ++i) error = std::max(error, std::abs(fast[i] - direct[i]));
+        assert(error < 1e-7);
+
+        if (n > 40) continue;
+        // интерполяция по значениям восстанавливает многочлен
+        Polynomial restored = Polynomial::interpolate(xs, direct);
+        std::vector<double> check = restored.evaluate(xs);
+        error = 0;
+        for (size_t i = 0; i < n; ++i) error = std::max(error, std::abs(check[i] - direct[i]));
+        assert(error < 1e-7);
+    }
+
+    // за пределами точности дерева - тот же ответ, что и Горнер по точкам
+    for (size_t n: {65, 128, 256, 1024}) {
+        std::vector<double> koefs(n), xs(n);
+        for (auto &k: koefs) k = real(generator);
+        for (auto &x: xs) x = real(generator);
+        Polynomial poly(koefs);
+        std::vector<double> fast = poly.evaluate_multipoint(xs);
+        for (size_t i = 0; i < n; ++i) assert(std::abs(fast[i] - poly(xs[i])) < 1e-12);
+    }
+
+    // число точек не ограничено: 49 различных узлов прямой на [-1, 1] и 200 целых узлов
+    std::vector<double> xs(49), ys(49);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = std::cos(std::numbers::pi * (static_cast<double>(i) + 0.5) / static_cast<double>(xs.size()));
+        ys[i] = 3 * xs[i] + 2;
+    }
+    Polynomial chebyshev_line = Polynomial::interpolate(xs, ys);
+    for (size_t i = 0; i < xs.size(); ++i) assert(std::abs(chebyshev_line(xs[i]) - ys[i]) < 1e-6);
+
+    xs.resize(200);
+    ys.resize(200);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = static_cast<double>(i);
+        ys[i] = 3 * xs[i] + 2;
+    }
+    Polynomial integer_line = Polynomial::interpolate(xs, ys);
+    assert(integer_line.getDegree() == 1 && integer_line(1000.0) == 3002.0);
+
+    Polynomial line = Polynomial::interpolate({1, 2, 3}, {2, 4, 6});
+    assert(std::abs(line(10.0) - 20.0) < 1e-12);
+
+    bool thrown = false;
+    try {
+        Polynomial::interpolate({1, 2, 1}, {0, 0, 0});
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void test_in_place() {
+    Polynomial p = {1, 2}, q = {3, 4};
+    assert(&(p += q) == &p && p == Polynomial({4, 6}));
+    assert(&(p -= q) == &p && p == Polynomial({1, 2}));
+    assert(&(p *= q) == &p && p == Polynomial({3, 10, 8}));
+
+    // операнд может совпадать с результатом
+    Polynomial r = {1, 1};
+    r *= r;
+    assert(r == Polynomial({1, 2, 1}));
+    r -= r;
+    assert(r == Polynomial({0, 0, 0}));
+
+    // временные операнды с обеих сторон
+    assert(Polynomial({1, 2}) - q == Polynomial({-2, -2}));
+    assert(q - Polynomial({1, 2}) == Polynomial({2, 2}));
+    assert(Polynomial({1}) + Polynomial({0, 1}) == Polynomial({1, 1}));
+    assert(-Polynomial({1, -1}) == Polynomial({-1, 1}));
+
+    // рост через границу встроенного буфера и обратно
+    Polynomial power = {1};
+    for (int i = 0; i < 40; ++i) power *= Polynomial({1, 1});
+    assert(power.getDegree() == 40 && power(1.0) == std::pow(2.0, 40));
+    Polynomial copy = power, moved = std::move(copy);
+    assert(moved == power);
+    assert(power.derivative().getDegree() == 39);
+    assert(power.multiply_monom(3).getDegree() == 43);
+}
+
+void test_sparse() {
+    // x^1000000 + 1
+    SparsePolynomial p(std::vector<Monom>{{1000000, 1.0}, {0, 1.0}});
+    assert(p.monoms().size() == 2 && p.getDegree() == 1000000);
+    assert(p(1.0) == 2.0 && p(-1.0) == 2.0 && p(0.5) == 1.0);
+
+    SparsePolynomial square = p * p;
+    assert(square == SparsePolynomial(std::vector<Monom>{{0, 1.0}, {1000000, 2.0}, {2000000, 1.0}}));
+    assert((square - p * p).monoms().empty());
+    assert(p.derivative() == SparsePolynomial(std::vector<Monom>{{999999, 1000000.0}}));
+    assert(p.multiply_monom(5).getDegree() == 1000005);
+
+    // (x - 1)(x^2 + x + 1) = x^3 - 1: средние члены сокращаются
+    SparsePolynomial a(std::vector<Monom>{{1, 1.0}, {0, -1.0}}), b(std::vector<Monom>{{2, 1.0}, {1, 1.0}, {0, 1.0}});
+    assert(a * b == SparsePolynomial(std::vector<Monom>{{0, -1.0}, {3, 1.0}}));
+
+    // совпадает с плотным умножением
+    Polynomial dense_a = {1, 0, 0, 2, 0, -1}, dense_b = {0, 3, 0, 0, 0, 0, 0, 4};
+    SparsePolynomial sparse_a(dense_a), sparse_b(dense_b);
+    assert((sparse_a * sparse_b).to_dense() == dense_a * dense_b);
+    assert((sparse_a + sparse_b).to_dense() == dense_a + dense_b);
+    assert((sparse_a - sparse_b).to_dense() == dense_a - dense_b);
+    assert(sparse_a.derivative().to_dense() == dense_a.derivative());
+    assert(std::abs(sparse_a(0.7) - dense_a(0.7)) < 1e-15);
+    assert(SparsePolynomial::prefers_sparse(p.to_dense()) && !SparsePolynomial::prefers_sparse(dense_a));
+
+    // плотное умножение само переходит на разреженное для редких длинных многочленов
+    std::vector<double> x(5000), y(4000);
+    x[0] = 1, x[1234] = 2, x[4999] = -1;
+    y[7] = 3, y[3999] = 0.5;
+    Polynomial product = Polynomial(x) * Polynomial(y);
+    assert(SparsePolynomial::prefers_sparse(Polynomial(x)) && SparsePolynomial::prefers_sparse(Polynomial(y)));
+    // на пороге советы и выбор умножения совпадают: 2% ненулевых - ещё разреженный, чуть больше - уже нет
+    std::vector<double> edge(1000);
+    for (size_t i = 0; i < 20; ++i) edge[i * 50] = 1;
+    assert(SparsePolynomial::prefers_sparse(Polynomial(edge)));
+    edge[1] = 1;
+    assert(!SparsePolynomial::prefers_sparse(Polynomial(edge)));
+    assert(SparsePolynomial(product) == SparsePolynomial(Polynomial(x)) * SparsePolynomial(Polynomial(y)));
+    assert(product.getDegree() == 4999 + 3999);
+}
+
+void test_exact_rings() {
+    using RationalPolynomial = BasicPolynomial<Rational>;
+    NumberType one = 1, two = 2, three = 3;
+
+    // деление и остаток без погрешности
+    RationalPolynomial a = {Rational(3), Rational(2), Rational(2), Rational(1)}, b = {Rational(1), Rational(2)};
+    auto [q, r] = a.divide(b);
+    assert(q * b + r == a && r.getDegree() == 0);
+    assert(r == RationalPolynomial({Rational(19, 8)})); // a(-1/2)
+
+    // интерполяция через точки 0..9 восстанавливает коэффициенты точно
+    RationalPolynomial original = {Rational(one, three), Rational(-2), Rational(0), Rational(5, 7), Rational(one, two)};
+    std::vector<Rational> xs, ys;
+    for (NumberType x = 0; x < 10; ++x) {
+        xs.emplace_back(x);
+        ys.push_back(original(Rational(x)));
+    }
+    assert(RationalPolynomial::interpolate(xs, ys) == original);
+    assert(original.evaluate_multipoint(xs) == ys);
+    assert(original.derivative() == RationalPolynomial({Rational(-2), Rational(0), Rational(15, 7), Rational(2)}));
+
+    // вычеты: NTT против столбика, деление Ньютоном, деревья на тысячах точек
+    using Mod = ModInt<998244353>;
+    using ModPolynomial = BasicPolynomial<Mod>;
+    static_assert(Mod::root_of_unity(1 << 23).pow(1 << 22) == Mod(-1));
+    assert(Mod(3) / Mod(7) * Mod(7) == Mod(3));
+
+    std::mt19937 generator(5);
+    auto random_poly = [&](size_t size) {
+        std::vector<Mod> koefs(size);
+        for (auto &k: koefs) k = generator();
+        koefs.back() = 1;
+        return ModPolynomial(koefs);
+    };
+
+    ModPolynomial x = random_poly(3000), y = random_poly(2000);
+    size_t karatsuba = ModPolynomial::karatsuba_threshold;
+    ModPolynomial::karatsuba_threshold = 1u << 30;
+    ModPolynomial expected = x * y;
+    ModPolynomial::karatsuba_threshold = karatsuba;
+    assert(x * y == expected);
+
+    auto [mod_q, mod_r] = x.divide_newton(y);
+    assert(mod_q * y + mod_r == x && mod_r.getDegree() < y.getDegree());
+    assert(x.divide_long(y) == std::make_pair(mod_q, mod_r));
+
+    std::vector<Mod> points(2000);
+    for (size_t i = 0; i < points.size(); ++i) points[i] = static_cast<int64_t>(i * i + 1);
+    std::vector<Mod> values = x.evaluate_multipoint(points);
+    for (size_t i = 0; i < points.size(); i += 97) assert(values[i] == x(points[i]));
+
+    ModPolynomial small = random_poly(2000);
+    assert(ModPolynomial::interpolate(points, small.evaluate(points)) == small);
+
+    // модуль без больших степеней двойки в p - 1: остаётся Карацуба
+    using Odd = ModInt<1000000007>;
+    static_assert(!Odd::supports_ntt(4096));
+    BasicPolynomial<Odd> u(std::vector<Odd>(500, Odd(3))), v(std::vector<Odd>(400, Odd(5)));
+    assert((u * v)(Odd(1)) == Odd(500 * 400 * 15));
+}
+
+/// Сопоставляет найденные корни с ожидаемыми жадно по ближайшему и возвращает наибольшее расхождение
+double roots_error(std::vector<std::complex<double>> found, const std::vector<std::complex<double>> &expected) {
+    assert(found.size() == expected.size());
+    double error = 0;
+    for (auto root: expected) {
+        auto nearest = std::min_element(found.begin(), found.end(), [&](auto a, auto b) {
+            return std::abs(a - root) < std::abs(b - root);
+        });
+        error = std::max(error, std::abs(*nearest - root));
+        found.erase(nearest);
+    }
+    return error;
+}
+
+void test_roots() {
+    using Complex = std::complex<double>;
+    assert(roots_error(Polynomial({-6, 11, -6, 1}).roots(), {1, 2, 3}) < 1e-12);
+    assert(roots_error(Polynomial({1, 0, 1}).roots(), {Complex(0, 1), Complex(0, -1)}) < 1e-14);
+    assert(roots_error(Polynomial({0, 0, -2, 1}).roots(), {0, 0, 2}) < 1e-14);
+    assert(Polynomial({5}).roots().empty());
+
+    // x^n - 1: корни из единицы
+    for (size_t n: {100, 500}) {
+        std::vector<double> koefs(n + 1);
+        koefs[0] = -1;
+        koefs[n] = 1;
+        std::vector<Complex> expected;
+        for (size_t k = 0; k < n; ++k) {
+            expected.push_back(std::polar(1.0, 2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(n)));
         }
+        assert(roots_error(Polynomial(koefs).roots(), expected) < 1e-12);
+    }
+
+    // многочлен степени 80 по известным корням в единичном круге, парами сопряжённых
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<double> radius(0.3, 1), angle(0, std::numbers::pi);
+    Polynomial poly = {1};
+    std::vector<Complex> expected;
+    for (int i = 0; i < 40; ++i) {
+        Complex root = std::polar(radius(generator), angle(generator));
+        expected.push_back(root);
+        expected.push_back(std::conj(root));
+        poly *= Polynomial({std::norm(root), -2 * root.real(), 1});
+    }
+    assert(roots_error(poly.roots(), expected) < 1e-6);
+}
+
+void test_single_poly(const Polynomial &poly, double(*realFunc)(double), const std::string &funcName, double eps) {
+    AccuracyReport report = AccuracySweep::run(poly, realFunc, -0.3, 0.3, 1 << 20);
+    std::cout << funcName << " | " << report << std::endl;
+
+    if ((report.max_abs_error > eps) || (report.max_rel_error > eps)) {
+        double x = report.worst_x;
+        std::cout << poly << " ~ " << funcName
+                  << " | x = " << x
+                  << " | poly = " << poly(x)
+                  << " | func = " << realFunc(x)
+                  << std::endl;
+    }
+}
+
+/// Ряды Тейлора ln(1+x) и sin(x)/x, посчитанные при компиляции
+constexpr FixedPolynomial log1p_taylor = {0.0, 1.0, -1.0 / 2.0, 1.0 / 3.0, -1.0 / 4.0, 1.0 / 5.0};
+constexpr FixedPolynomial sinc_taylor = {1.0, 0.0, -1.0 / 6.0, 0.0, 1.0 / 120.0, 0.0, -1.0 / 5040.0};
+
+void test_fixed() {
+    constexpr auto product = log1p_taylor * sinc_taylor;
+    static_assert(std::is_same_v<decltype(product), const FixedPolynomial<11>>);
+    static_assert(product(0.0) == 0.0 && product[1] == 1.0 && product[2] == -0.5);
+    static_assert(log1p_taylor.derivative() == FixedPolynomial{1.0, -1.0, 1.0, -1.0, 1.0});
+    static_assert(FixedPolynomial{1.0, 2.0}(2.0) == 5.0);
+    static_assert((FixedPolynomial{1.0, 2.0} - FixedPolynomial{1.0, 2.0, 3.0}) == FixedPolynomial{0.0, 0.0, -3.0});
+
+    // Горнер, Эстрин и обычный Polynomial совпадают
+    Polynomial dense = product.to_polynomial();
+    assert(dense == Polynomial(log1p_taylor.to_polynomial() * sinc_taylor.to_polynomial()));
+    for (double x = -0.5; x <= 0.5; x += 0.125) {
+        assert(std::abs(product(x) - dense(x)) < 1e-15);
+        assert(std::abs(product.estrin(x) - dense(x)) < 1e-15);
     }
+    assert(FixedPolynomial<11>(dense) == product);
 
+    std::vector<double> xs = {0.1, 0.2, 0.3}, values(xs.size());
+    sinc_taylor.evaluate(xs.data(), xs.size(), values.data());
+    assert(values == sinc_taylor.to_polynomial().evaluate(xs));
 
+    bool thrown = false;
+    try {
+        FixedPolynomial<3> small(dense);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void test_composition() {
+    Polynomial p = {1, 2, 3};
+    assert(p.compose({0, 1, 1}) == Polynomial({1, 2, 5, 6, 3}));
+    assert(p.compose({7}) == Polynomial({162}));
+    assert(p.shift(1) == Polynomial({6, 8, 3}));
+    assert(Polynomial({0}).compose(p) == Polynomial({0}));
+
+    std::mt19937 generator(21);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    std::vector<double> koefs(40);
+    for (double &koef: koefs) koef = distribution(generator);
+    Polynomial random(koefs);
+    assert(random.compose({0, 1}) == random);
+
+    // сдвиг туда и обратно и значения в точках
+    Polynomial shifted = random.shift(0.25), back = shifted.shift(-0.25);
+    for (size_t i = 0; i < koefs.size(); ++i) assert(std::abs(back[i] - koefs[i]) < 1e-9);
+    for (double x = -0.5; x <= 0.5; x += 0.125) assert(std::abs(shifted(x) - random(x + 0.25)) < 1e-9);
+    Polynomial inner = {0.1, 0.5, -0.3};
+    Polynomial composed = random.compose(inner);
+    assert(composed.getDegree() == 2 * random.getDegree());
+    for (double x = -0.5; x <= 0.5; x += 0.125) assert(std::abs(composed(x) - random(inner(x))) < 1e-9);
+
+    // точно: делением пополам против Горнера
+    using Mod = ModInt<998244353>;
+    using ModPolynomial = BasicPolynomial<Mod>;
+    std::vector<Mod> mod_koefs(1000);
+    for (Mod &koef: mod_koefs) koef = generator();
+    ModPolynomial mod_p(mod_koefs), mod_q = {Mod(5), Mod(1), Mod(3), Mod(2)};
+    ModPolynomial fast = mod_p.compose(mod_q), fast_shift = mod_p.shift(Mod(12345));
+    size_t threshold = ModPolynomial::composition_threshold;
+    ModPolynomial::composition_threshold = 1u << 30;
+    assert(fast == mod_p.compose(mod_q) && fast_shift == mod_p.shift(Mod(12345)));
+    ModPolynomial::composition_threshold = threshold;
+    assert(fast_shift.shift(-Mod(12345)) == mod_p);
+
+    using RationalPolynomial = BasicPolynomial<Rational>;
+    NumberType one = 1, two = 2;
+    RationalPolynomial cube = {Rational(0), Rational(0), Rational(0), Rational(1)};
+    assert(cube.shift(Rational(one, two)) ==
+           RationalPolynomial({Rational(1, 8), Rational(3, 4), Rational(3, 2), Rational(1)}));
+}
+
+void test_accuracy_sweep() {
+    assert(AccuracySweep::ulp_distance(1, std::nextafter(1.0, 2.0)) == 1);
+    assert(AccuracySweep::ulp_distance(-0.0, 0.0) == 0);
+    double tiny = std::numeric_limits<double>::denorm_min();
+    assert(AccuracySweep::ulp_distance(-tiny, tiny) == 2);
+    assert(AccuracySweep::ulp_distance(-1, 1) == 2 * AccuracySweep::ulp_distance(0, 1));
+
+    Polynomial identity = {0, 1};
+    AccuracyReport next = AccuracySweep::run(identity, [](double x) { return std::nextafter(x, 3.0); }, 1, 2, 100000);
+    assert(next.points == 100000 && next.skipped == 0);
+    assert(next.max_ulp_error == 1 && next.mean_ulp_error == 1);
+
+    AccuracyReport offset = AccuracySweep::run(Polynomial({1e-3, 1}), [](double x) { return x; }, 1, 2, 100000);
+    assert(std::abs(offset.max_abs_error - 1e-3) < 1e-12 && std::abs(offset.mean_abs_error - 1e-3) < 1e-12);
+    assert(std::abs(offset.max_rel_error - 1e-3) < 1e-12 && offset.mean_rel_error < offset.max_rel_error);
+
+    // в нуле sin(x)/x не определён, точка пропускается; FixedPolynomial проходит тем же путём
+    AccuracyReport sinc = AccuracySweep::run(sinc_taylor, [](double x) { return std::sin(x) / x; }, -0.3, 0.3,
+                                             (1 << 20) + 1);
+    assert(sinc.skipped == 1 && sinc.max_rel_error < 1e-6 && std::abs(sinc.worst_x) == 0.3);
+
+    // NaN приближения не должен давать идеальную оценку
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    assert(AccuracySweep::ulp_distance(nan, 1) == std::numeric_limits<uint64_t>::max());
+    assert(AccuracySweep::ulp_distance(nan, nan) == std::numeric_limits<uint64_t>::max());
+    struct Broken {
+        void evaluate(const double *xs, size_t count, double *out) const {
+            for (size_t i = 0; i < count; ++i) out[i] = xs[i] == 1.5 ? std::numeric_limits<double>::quiet_NaN() : xs[i];
+        }
+    };
+    AccuracyReport broken = AccuracySweep::run(Broken(), [](double x) { return x; }, 1, 2, 100001);
+    assert(broken.non_finite == 1 && broken.skipped == 0 && broken.worst_x == 1.5);
+    assert(std::isinf(broken.max_abs_error) && std::isinf(broken.max_rel_error));
+    assert(broken.max_ulp_error == std::numeric_limits<uint64_t>::max());
+    assert(broken.mean_abs_error == 0 && broken.mean_ulp_error == 0);
+}
+
+void test_approximation() {
+    // ln(1+x) на [-0.3, 0.3]: Тейлору нужно 5 членов, чтобы уложиться в 1e-3
+    auto log1p = [](double x) { return std::log(1 + x); };
+    Approximation approximation = PolynomialApproximation::build(log1p, -0.3, 0.3, 1e-3);
+    assert(approximation.error <= 1e-3 && approximation.poly.getDegree() < 5);
+    std::cout << "ln(1+x) ~ " << approximation.poly << " | error " << approximation.error << std::endl;
+
+    // наилучшее равномерное не хуже интерполянта Чебышёва той же степени и почти равноколеблется
+    for (size_t degree: {3, 6, 10}) {
+        auto chebyshev = PolynomialApproximation::chebyshev([](double x) { return std::exp(x); }, 0, 1, degree);
+        auto minimax = PolynomialApproximation::remez([](double x) { return std::exp(x); }, 0, 1, degree);
+        assert(minimax.error <= chebyshev.error);
+    }
+    // наилучшая прямая для e^x на [0, 1] известна явно: наклон e - 1, ошибка ~0.1059
+    auto line = PolynomialApproximation::remez([](double x) { return std::exp(x); }, 0, 1, 1);
+    double slope = std::numbers::e - 1, touch = std::log(slope);
+    double expected = (1 - (std::exp(touch) - slope * touch)) / 2;
+    assert(std::abs(std::abs(line.error) - std::abs(expected)) < 1e-9);
+
+    auto sin_approximation = PolynomialApproximation::build([](double x) { return std::sin(x); }, -1, 1, 1e-12);
+    assert(sin_approximation.error <= 1e-12 && sin_approximation.poly.getDegree() <= 15);
+
+    // точный многочлен восстанавливается сразу
+    auto cubic = PolynomialApproximation::build([](double x) { return x * x * x - x; }, -2, 2, 1e-12);
+    assert(cubic.poly.getDegree() == 3 && cubic.error <= 1e-12);
 }
 
 void test_poly() {
 
-    Polynomial p = Polynomial({0.0, 1, -1.0 / 2.0, 1.0 / 3.0, -1.0 / 4.0, 1.0 / 5.0});
+    Polynomial p = log1p_taylor.to_polynomial();
 
 
     test_single_poly(
@@ -270,7 +2446,7 @@ void test_poly() {
             1e-3
     );
 
-    Polynomial q = Polynomial({1, 0.0, -1.0 / 6.0, 0.0, 1.0 / 120.0, 0.0, -1.0 / 5040.0});
+    Polynomial q = sinc_taylor.to_polynomial();
     test_single_poly(
             q,
             [](double x) { return sin(x) / x; },
@@ -309,19 +2485,80 @@ void test_div() {
     auto [quotient, remainder] = divisible.divide(divisor);
     std::cout << "quotient " << quotient << std::endl;
     std::cout << "remainder " << remainder << std::endl;
+    assert(quotient == Polynomial({1, 1, 1}));
+    assert(remainder == Polynomial({2}));
+
+    auto [q3, r3] = Polynomial({-1, 0, 0, 2}).divide(Polynomial({1, 0, 2}));
+    assert(q3 == Polynomial({0, 1}));
+    assert(r3 == Polynomial({-1, -1}));
 
     auto [q, r] = divisible.divide(Polynomial({1}));
     assert(q == divisible);
     assert(r == Polynomial());
 
+    // частное не представимо точно, но остаток от деления на константу всё равно ровно ноль
+    auto [q4, r4] = Polynomial({-1.6393197245967208}).divide(Polynomial({0.3283578963247198}));
+    assert(q4 == Polynomial({-1.6393197245967208 / 0.3283578963247198}));
+    assert(r4 == Polynomial());
+    std::mt19937 constant_generator(12);
+    std::uniform_real_distribution<double> constant(-2, 2);
+    for (int i = 0; i < 1000; ++i) {
+        Polynomial dividend = {constant(constant_generator), constant(constant_generator), constant(constant_generator)};
+        assert(dividend.divide(Polynomial({constant(constant_generator)})).second == Polynomial());
+    }
+
     Polynomial big = Polynomial({1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1});
     auto [q2, r2] = divisible.divide(big);
     assert(q2 == Polynomial());
     assert(r2 == divisible);
+
+    bool thrown = false;
+    try {
+        divisible.divide(Polynomial({0, 0}));
+    } catch (const std::domain_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    assert((Polynomial({0, 0, 0}) * Polynomial({1, 2})).getDegree() == 0);
+
+    // деление через ряд Ньютона совпадает со столбиком
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> real(-1, 1);
+    for (auto [n, m]: {std::pair<size_t, size_t>{300, 100}, {1000, 200}, {2000, 1000}, {5000, 64}}) {
+        std::vector<double> a(n), b(m);
+        for (auto &x: a) x = real(generator);
+        for (auto &x: b) x = real(generator);
+        // старший коэффициент больше суммы остальных: у перевёрнутого делителя нет корней в единичном круге,
+        // обратный ряд убывает и деление хорошо обусловлено
+        b.back() = static_cast<double>(m);
+
+        Polynomial dividend(a), d(b);
+        auto [fast_q, fast_r] = dividend.divide_newton(d);
+        auto [long_q, long_r] = dividend.divide_long(d);
+        assert(fast_q.getDegree() == n - m && fast_r.getDegree() <= m - 2);
+
+        Polynomial q_error = fast_q - long_q, r_error = fast_r - long_r;
+        for (double x = -1; x <= 1; x += 0.25) {
+            assert(std::abs(q_error(x)) < 1e-8 * (1 + std::abs(long_q(x))));
+            assert(std::abs(r_error(x)) < 1e-8 * (1 + std::abs(long_r(x))));
+        }
+    }
 }
 
 int main() {
     test_simple();
+    test_multiply();
+    test_evaluate();
+    test_multipoint();
+    test_in_place();
+    test_sparse();
+    test_exact_rings();
+    test_roots();
+    test_fixed();
+    test_composition();
+    test_accuracy_sweep();
+    test_approximation();
     test_poly();
     test_div();
 }
\ No newline at end of file
@@ -1,83 +1,600 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <random>
+#include <limits>
+#include <stdexcept>
+#include <cstring>
 #include <cassert>
-#include <io.h>
 
-using StringRef = const std::string &;
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+using StringRef = std::string_view;
 
 void warning(StringRef msg) {
     std::cout << "[WARNING] " << msg << std::endl;
 }
 
 
+/// Хеш-таблица с открытой адресацией на плоских массивах. В слотах лежат только 32-битные номера записей, сами ключи
+/// хранятся снаружи и достаются функцией key_of(id) -> std::string_view, которую передают в каждый вызов. На каждый
+/// слот приходится управляющий байт: старший бит выставлен у пустых и удалённых, у занятых там младшие 7 бит хеша.
+/// Байты идут группами по 16 и сравниваются с искомыми 7 битами сразу всей группой (SSE2, либо побайтово), так что
+/// ключи сравниваются почти только при настоящем совпадении. Поиск принимает std::string_view и ничего не выделяет
+class FlatIdIndex {
+public:
+    static constexpr size_t group_width = 16;
+
+    [[nodiscard]] size_t size() const { return _size; }
+
+    [[nodiscard]] size_t capacity() const { return _control.size(); }
+
+    /// Места хватит на count элементов без перестройки
+    template<typename KeyOf>
+    void reserve(size_t count, KeyOf key_of) {
+        size_t groups = 1;
+        while (groups * group_width * 7 / 8 < count) groups *= 2;
+        if (groups > group_count()) rehash(groups, key_of);
+    }
+
+    template<typename KeyOf>
+    [[nodiscard]] std::optional<uint32_t> find(std::string_view key, KeyOf key_of) const {
+        size_t index = find_index(key, std::hash<std::string_view>{}(key), key_of);
+        if (index == npos) return std::nullopt;
+        return _ids[index];
+    }
+
+    /// Возвращает true, если ключ был новым
+    template<typename KeyOf>
+    bool insert_or_assign(std::string_view key, uint32_t id, KeyOf key_of) {
+        size_t hash = std::hash<std::string_view>{}(key);
+        size_t index = find_index(key, hash, key_of);
+        if (index != npos) {
+            _ids[index] = id;
+            return false;
+        }
+
+        if ((_size + _deleted + 1) * 8 > capacity() * 7) {
+            // если место съели удалённые, хватит перестройки того же размера
+            size_t groups = group_count();
+            rehash(_size * 2 >= capacity() * 7 / 8 || groups == 0 ? std::max<size_t>(1, groups * 2) : groups, key_of);
+        }
+        index = free_index(hash);
+        if (_control[index] == deleted) --_deleted;
+        _control[index] = short_hash(hash);
+        _ids[index] = id;
+        ++_size;
+        return true;
+    }
+
+    template<typename KeyOf>
+    bool erase(std::string_view key, KeyOf key_of) {
+        size_t index = find_index(key, std::hash<std::string_view>{}(key), key_of);
+        if (index == npos) return false;
+
+        _control[index] = deleted;
+        --_size;
+        ++_deleted;
+        return true;
+    }
+
+    /// function(uint32_t id) для каждого элемента в порядке слотов
+    template<typename Function>
+    void for_each(Function function) const {
+        for (size_t index = 0; index < capacity(); ++index) {
+            if (_control[index] >= 0) function(_ids[index]);
+        }
+    }
+
+    /// Перенумерация записей id -> new_ids[id]: ключи не меняются, поэтому слоты остаются на местах
+    void remap(const std::vector<uint32_t> &new_ids) {
+        for (size_t index = 0; index < capacity(); ++index) {
+            if (_control[index] >= 0) _ids[index] = new_ids[_ids[index]];
+        }
+    }
+
+private:
+    static constexpr int8_t empty = -128, deleted = -2;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    [[nodiscard]] size_t group_count() const { return capacity() / group_width; }
+
+    static int8_t short_hash(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+
+    /// Биты маски - позиции группы, где управляющий байт равен byte
+    static uint32_t match(const int8_t *group, int8_t byte) {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(byte))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_width; ++i) mask |= static_cast<uint32_t>(group[i] == byte) << i;
+        return mask;
+#endif
+    }
+
+    /// Биты маски - пустые или удалённые позиции группы
+    static uint32_t match_free(const int8_t *group) {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_width; ++i) mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        return mask;
+#endif
+    }
+
+    /// Группы перебираются квадратично: g, g + 1, g + 3, g + 6, ... - при числе групп 2^k обходятся все
+    template<typename KeyOf>
+    size_t find_index(std::string_view key, size_t hash, KeyOf &key_of) const {
+        size_t groups = group_count();
+        if (groups == 0) return npos;
+        int8_t byte = short_hash(hash);
+        size_t group = (hash >> 7) & (groups - 1);
+        for (size_t step = 1; step <= groups; ++step) {
+            const int8_t *control = _control.data() + group * group_width;
+            for (uint32_t mask = match(control, byte); mask != 0; mask &= mask - 1) {
+                size_t index = group * group_width + static_cast<size_t>(std::countr_zero(mask));
+                if (key_of(_ids[index]) == key) return index;
+            }
+            if (match(control, empty) != 0) return npos;
+            group = (group + step) & (groups - 1);
+        }
+        return npos;
+    }
+
+    [[nodiscard]] size_t free_index(size_t hash) const {
+        size_t groups = group_count();
+        size_t group = (hash >> 7) & (groups - 1);
+        for (size_t step = 1;; ++step) {
+            uint32_t mask = match_free(_control.data() + group * group_width);
+            if (mask != 0) return group * group_width + static_cast<size_t>(std::countr_zero(mask));
+            group = (group + step) & (groups - 1);
+        }
+    }
+
+    template<typename KeyOf>
+    void rehash(size_t groups, KeyOf &key_of) {
+        std::vector<int8_t> control(groups * group_width, empty);
+        std::vector<uint32_t> ids(groups * group_width);
+        control.swap(_control);
+        ids.swap(_ids);
+        _deleted = 0;
+
+        for (size_t index = 0; index < control.size(); ++index) {
+            if (control[index] < 0) continue;
+            size_t hash = std::hash<std::string_view>{}(key_of(ids[index]));
+            size_t target = free_index(hash);
+            _control[target] = short_hash(hash);
+            _ids[target] = ids[index];
+        }
+    }
+
+    std::vector<int8_t> _control;
+    std::vector<uint32_t> _ids;
+    size_t _size = 0, _deleted = 0;
+};
+
+
+/// Номера записей, упорядоченные по ключу key_of(id) без повторов, в плотных массивах 32-битных id: запрос по
+/// префиксу - двоичные поиски. Чтобы правки не сдвигали весь основной массив, они копятся отдельно: свежие вставки -
+/// в небольшом упорядоченном массиве, удаления из основного - пометками по id (ключ помеченной записи должен читаться
+/// до следующей перенумерации). И то и другое вливается в основной массив, когда его становится больше корня из
+/// размера основного, так что вставка и удаление стоят O(sqrt n), а не O(n)
+class SortedIdIndex {
+public:
+    /// Меньше стольких отложенных вставок или удалений в основной массив не вливаем
+    inline static size_t min_pending = 1024;
+
+    [[nodiscard]] size_t size() const { return _ids.size() + _recent.size() - _erased.size(); }
+
+    template<typename KeyOf>
+    void build(std::vector<uint32_t> ids, KeyOf key_of) {
+        std::sort(ids.begin(), ids.end(), [&](uint32_t lhs, uint32_t rhs) { return key_of(lhs) < key_of(rhs); });
+        _ids = std::move(ids);
+        _recent.clear();
+        fold_erased();
+    }
+
+    template<typename KeyOf>
+    void insert(uint32_t id, KeyOf key_of) {
+        _recent.insert(lower_bound(_recent, key_of(id), key_of), id);
+        if (!too_many(_recent.size())) return;
+
+        fold_erased();
+        // ключи основного массива лежат в памяти вразнобой, поэтому не сравниваем их между собой: место каждой свежей
+        // записи ищем двоичным поиском, а куски основного массива между ними копируем целиком
+        std::vector<uint32_t> merged;
+        merged.reserve(_ids.size() + _recent.size());
+        auto copied = _ids.cbegin();
+        for (uint32_t recent: _recent) {
+            std::string_view key = key_of(recent);
+            auto position = std::partition_point(copied, _ids.cend(), [&](uint32_t other) {
+                return key_of(other) < key;
+            });
+            merged.insert(merged.end(), copied, position);
+            merged.push_back(recent);
+            copied = position;
+        }
+        merged.insert(merged.end(), copied, _ids.cend());
+        _ids.swap(merged);
+        _recent.clear();
+    }
+
+    /// Ключ key уже есть, теперь он принадлежит записи id
+    template<typename KeyOf>
+    void assign(std::string_view key, uint32_t id, KeyOf key_of) {
+        auto [ids, position] = find(key, key_of);
+        if (ids != nullptr) *position = id;
+    }
+
+    template<typename KeyOf>
+    void erase(std::string_view key, KeyOf key_of) {
+        auto [ids, position] = find(key, key_of);
+        if (ids == &_recent) {
+            _recent.erase(position);
+        } else if (ids != nullptr) {
+            mark_erased(*position);
+            if (too_many(_erased.size())) fold_erased();
+        }
+    }
+
+    /// Перенумерация после сжатия хранилища: помеченные записи к этому времени уже исчезли, их убираем заранее
+    void remap(const std::vector<uint32_t> &new_ids) {
+        fold_erased();
+        for (uint32_t &id: _ids) id = new_ids[id];
+        for (uint32_t &id: _recent) id = new_ids[id];
+    }
+
+    /// Не больше count записей с ключами, начинающимися с prefix и строго большими after, по возрастанию ключа
+    template<typename KeyOf>
+    [[nodiscard]] std::vector<uint32_t> prefix_ids(std::string_view prefix, std::optional<std::string_view> after,
+                                                   size_t count, KeyOf key_of) const {
+        auto [first, last] = prefix_range(_ids, prefix, after, key_of);
+        auto [recent_first, recent_last] = prefix_range(_recent, prefix, after, key_of);
+
+        std::vector<uint32_t> result;
+        while (result.size() < count && (first != last || recent_first != recent_last)) {
+            if (first != last && is_erased(*first)) {
+                ++first;
+            } else if (recent_first == recent_last || (first != last && key_of(*first) < key_of(*recent_first))) {
+                result.push_back(*first++);
+            } else {
+                result.push_back(*recent_first++);
+            }
+        }
+        return result;
+    }
+
+private:
+    using Iterator = std::vector<uint32_t>::const_iterator;
+
+    [[nodiscard]] bool too_many(size_t pending) const {
+        return pending * pending > _ids.size() && pending > min_pending;
+    }
+
+    [[nodiscard]] bool is_erased(uint32_t id) const {
+        return id < _is_erased.size() && _is_erased[id];
+    }
+
+    void mark_erased(uint32_t id) {
+        if (id >= _is_erased.size()) _is_erased.resize(id + 1);
+        _is_erased[id] = true;
+        _erased.push_back(id);
+    }
+
+    /// Убирает помеченные записи из основного массива за один проход
+    void fold_erased() {
+        if (_erased.empty()) return;
+        std::erase_if(_ids, [this](uint32_t id) { return is_erased(id); });
+        for (uint32_t id: _erased) _is_erased[id] = false;
+        _erased.clear();
+    }
+
+    template<typename KeyOf>
+    static Iterator lower_bound(const std::vector<uint32_t> &ids, std::string_view key, KeyOf &key_of) {
+        return std::partition_point(ids.begin(), ids.end(), [&](uint32_t id) { return key_of(id) < key; });
+    }
+
+    /// Живая запись с ключом key: сначала среди свежих, потом в основном массиве, где помеченная запись с тем же ключом
+    /// не считается
+    template<typename KeyOf>
+    std::pair<std::vector<uint32_t> *, std::vector<uint32_t>::iterator> find(std::string_view key, KeyOf &key_of) {
+        for (std::vector<uint32_t> *ids: {&_recent, &_ids}) {
+            auto position = ids->begin() + (lower_bound(*ids, key, key_of) - ids->cbegin());
+            if (position != ids->end() && key_of(*position) == key && !is_erased(*position)) return {ids, position};
+        }
+        return {nullptr, {}};
+    }
+
+    template<typename KeyOf>
+    static std::pair<Iterator, Iterator> prefix_range(const std::vector<uint32_t> &ids, std::string_view prefix,
+                                                      std::optional<std::string_view> after, KeyOf &key_of) {
+        auto first = std::partition_point(ids.begin(), ids.end(), [&](uint32_t id) {
+            std::string_view key = key_of(id);
+            return key < prefix || (after && key <= *after);
+        });
+        // ключи с префиксом идут подряд сразу за ключами меньше него
+        auto last = std::partition_point(first, ids.end(), [&](uint32_t id) {
+            return key_of(id).starts_with(prefix);
+        });
+        return {first, last};
+    }
+
+    std::vector<uint32_t> _ids, _recent, _erased;
+    std::vector<bool> _is_erased;
+};
+
+
+/// Записи книги лежат по одному разу подряд в общем буфере: имя, сразу за ним номер. Запись задаётся 32-битным id.
+/// Удаление только учитывает освободившиеся байты, сами байты остаются читаемыми до compact(), который сдвигает
+/// живые записи к началу
+class RecordArena {
+public:
+    uint32_t append(std::string_view name, std::string_view phone_number) {
+        size_t offset = _bytes.size();
+        if (offset + name.size() + phone_number.size() > std::numeric_limits<uint32_t>::max() ||
+            _records.size() >= std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("phone book arena is full");
+        }
+
+        _bytes.insert(_bytes.end(), name.begin(), name.end());
+        _bytes.insert(_bytes.end(), phone_number.begin(), phone_number.end());
+        _records.push_back({static_cast<uint32_t>(offset), static_cast<uint32_t>(name.size()),
+                            static_cast<uint32_t>(phone_number.size())});
+        return static_cast<uint32_t>(_records.size() - 1);
+    }
+
+    [[nodiscard]] std::string_view name(uint32_t id) const {
+        const Record &record = _records[id];
+        return {_bytes.data() + record.offset, record.name_size};
+    }
+
+    [[nodiscard]] std::string_view phone_number(uint32_t id) const {
+        const Record &record = _records[id];
+        return {_bytes.data() + record.offset + record.name_size, record.phone_number_size};
+    }
+
+    /// id -> ключ для FlatIdIndex
+    [[nodiscard]] auto names() const {
+        return [this](uint32_t id) { return name(id); };
+    }
+
+    [[nodiscard]] auto phone_numbers() const {
+        return [this](uint32_t id) { return phone_number(id); };
+    }
+
+    void release(uint32_t id) {
+        _released_bytes += _records[id].name_size + _records[id].phone_number_size;
+    }
+
+    [[nodiscard]] size_t bytes() const { return _bytes.size(); }
+
+    [[nodiscard]] size_t released_bytes() const { return _released_bytes; }
+
+    void reserve(size_t records, size_t bytes) {
+        _records.reserve(records);
+        _bytes.reserve(bytes);
+    }
+
+    /// Оставляет только записи live (по возрастанию id) и возвращает новые номера: new_ids[old_id]
+    std::vector<uint32_t> compact(const std::vector<uint32_t> &live) {
+        std::vector<uint32_t> new_ids(_records.size());
+        size_t written = 0;
+        for (size_t i = 0; i < live.size(); ++i) {
+            Record record = _records[live[i]];
+            size_t size = record.name_size + record.phone_number_size;
+            // записи идут в буфере по возрастанию id, так что сдвиг всегда к началу
+            if (record.offset != written) {
+                std::memmove(_bytes.data() + written, _bytes.data() + record.offset, size);
+            }
+            _records[i] = {static_cast<uint32_t>(written), record.name_size, record.phone_number_size};
+            new_ids[live[i]] = static_cast<uint32_t>(i);
+            written += size;
+        }
+
+        _bytes.resize(written);
+        _bytes.shrink_to_fit();
+        _records.resize(live.size());
+        _records.shrink_to_fit();
+        _released_bytes = 0;
+        return new_ids;
+    }
+
+private:
+    struct Record {
+        uint32_t offset, name_size, phone_number_size;
+    };
+
+    std::vector<char> _bytes;
+    std::vector<Record> _records;
+    size_t _released_bytes = 0;
+};
+
+
+/// Страница поиска по префиксу: пары (имя, номер) по возрастанию ключа поиска. Если совпадений больше, чем влезло,
+/// cursor - последний выданный ключ; передав его обратно, получим следующую страницу, даже если книгу меняли
+struct PrefixPage {
+    std::vector<std::pair<std::string_view, std::string_view>> entries;
+    std::optional<std::string> cursor;
+};
+
+
+/// Ссылки из search_* действительны до следующего изменения книги
 class PhoneBook {
 public:
 
+    /// Хранилище сжимается, когда удалённые записи занимают больше такой доли его байтов
+    inline static double compaction_ratio = 0.5;
+
     PhoneBook() = default;
 
     explicit PhoneBook(const std::map<std::string, std::string> &dict) {
-        _lookup = dict;
+        size_t bytes = 0;
+        for (const auto &[name, phone_number]: dict) bytes += name.size() + phone_number.size();
+        _arena.reserve(dict.size(), bytes);
+        _lookup.reserve(dict.size(), _arena.names());
+        _reverse_lookup.reserve(dict.size(), _arena.phone_numbers());
         for (const auto &[name, phone_number]: dict) {
-            _reverse_lookup[phone_number] = name;
+            uint32_t id = _arena.append(name, phone_number);
+            _lookup.insert_or_assign(name, id, _arena.names());
+            _reverse_lookup.insert_or_assign(phone_number, id, _arena.phone_numbers());
         }
+
+        _sorted_names.build(live_ids(), _arena.names());
+        std::vector<uint32_t> owners;
+        _reverse_lookup.for_each([&](uint32_t id) { owners.push_back(id); });
+        _sorted_phone_numbers.build(std::move(owners), _arena.phone_numbers());
     }
 
 
     /// При перезаписи возвращает true и логирует это
     bool add(StringRef name, StringRef phone_number) {
+        // аргументы могут указывать внутрь самой книги (результат search_*), а дописывание может переложить буфер
+        std::string name_copy(name), phone_number_copy(phone_number);
         bool warn = false;
-        if (_lookup.contains(name)) {
-            warning(name + "(" + phone_number + ") already in book");
+        std::optional<uint32_t> old = _lookup.find(name_copy, _arena.names());
+        if (old) {
+            warning(name_copy + "(" + phone_number_copy + ") already in book");
             warn = true;
+            release_phone_number(*old);
         }
 
-        _lookup[name] = phone_number;
-        _reverse_lookup[phone_number] = name;
+        uint32_t id = _arena.append(name_copy, phone_number_copy);
+        if (_lookup.insert_or_assign(name_copy, id, _arena.names())) {
+            _sorted_names.insert(id, _arena.names());
+        } else {
+            _sorted_names.assign(name_copy, id, _arena.names());
+        }
+        if (_reverse_lookup.insert_or_assign(phone_number_copy, id, _arena.phone_numbers())) {
+            _sorted_phone_numbers.insert(id, _arena.phone_numbers());
+        } else {
+            _sorted_phone_numbers.assign(phone_number_copy, id, _arena.phone_numbers());
+        }
+        if (old) release(*old);
 
         return warn;
     }
 
     bool remove(StringRef name) {
-        if (!_lookup.contains(name)) return false;
+        std::optional<uint32_t> id = _lookup.find(name, _arena.names());
+        if (!id) return false;
+
+        release_phone_number(*id);
+        _lookup.erase(_arena.name(*id), _arena.names());
+        _sorted_names.erase(_arena.name(*id), _arena.names());
+        release(*id);
+        return true;
+    }
+
+
+    [[nodiscard]] std::optional<std::string_view> search_by_name(StringRef name) const {
+        std::optional<uint32_t> id = _lookup.find(name, _arena.names());
+        if (!id) return std::nullopt;
 
-        std::string phone_number = _lookup[name];
-        _lookup.erase(name);
-        return _reverse_lookup.erase(phone_number);
+        return _arena.phone_number(*id);
     }
 
+    [[nodiscard]] std::optional<std::string_view> search_by_phone_number(StringRef phone_number) const {
+        std::optional<uint32_t> id = _reverse_lookup.find(phone_number, _arena.phone_numbers());
+        if (!id) return std::nullopt;
+
+        return _arena.name(*id);
+    }
 
-    [[nodiscard]] std::optional<std::string> search_by_name(StringRef name) const {
-        return common_search(_lookup, name);
 
+    /// Имена, начинающиеся с prefix, по алфавиту, не больше limit за раз
+    [[nodiscard]] PrefixPage search_by_name_prefix(StringRef prefix, size_t limit,
+                                                   std::optional<StringRef> cursor = std::nullopt) const {
+        return prefix_page(_sorted_names, prefix, limit, cursor, _arena.names());
     }
 
-    [[nodiscard]] std::optional<std::string> search_by_phone_number(StringRef phone_number) const {
-        return common_search(_reverse_lookup, phone_number);
+    /// Номера, начинающиеся с prefix, по возрастанию номера, не больше limit за раз
+    [[nodiscard]] PrefixPage search_by_phone_number_prefix(StringRef prefix, size_t limit,
+                                                           std::optional<StringRef> cursor = std::nullopt) const {
+        return prefix_page(_sorted_phone_numbers, prefix, limit, cursor, _arena.phone_numbers());
     }
 
 
-    void print() {
-        for (const auto &[name, phone_number]: _lookup) {
-            std::cout << name << " - " << phone_number << std::endl;
+    /// По алфавиту имён
+    void print() const {
+        for (uint32_t id: _sorted_names.prefix_ids("", std::nullopt, _sorted_names.size(), _arena.names())) {
+            std::cout << _arena.name(id) << " - " << _arena.phone_number(id) << std::endl;
         }
     }
 
+    [[nodiscard]] size_t size() const { return _lookup.size(); }
+
+    /// Байты под имена и номера, включая ещё не собранные удалённые
+    [[nodiscard]] size_t storage_bytes() const { return _arena.bytes(); }
+
 private:
 
-    static std::optional<std::string>
-    common_search(const std::map<std::string, std::string> &data, const std::string &key) {
-        auto search = data.find(key);
+    [[nodiscard]] std::vector<uint32_t> live_ids() const {
+        std::vector<uint32_t> ids;
+        ids.reserve(_lookup.size());
+        _lookup.for_each([&](uint32_t id) { ids.push_back(id); });
+        return ids;
+    }
 
-        if (search == data.end()) return std::nullopt;
+    /// Берём на одну запись больше limit, чтобы знать, нужен ли курсор
+    template<typename KeyOf>
+    [[nodiscard]] PrefixPage prefix_page(const SortedIdIndex &index, StringRef prefix, size_t limit,
+                                         std::optional<StringRef> cursor, KeyOf key_of) const {
+        std::vector<uint32_t> ids = index.prefix_ids(prefix, cursor, std::min(limit, index.size()) + 1, key_of);
+        PrefixPage page;
+        if (ids.size() > limit) {
+            ids.pop_back();
+            if (!ids.empty()) page.cursor = std::string(key_of(ids.back()));
+        }
+        page.entries.reserve(ids.size());
+        for (uint32_t id: ids) page.entries.emplace_back(_arena.name(id), _arena.phone_number(id));
+        return page;
+    }
 
-        return std::optional<std::string>{search->second};
+    /// Номер освобождается, только если по нему записан именно этот человек: номер могли переписать на другого
+    void release_phone_number(uint32_t id) {
+        std::string_view phone_number = _arena.phone_number(id);
+        std::optional<uint32_t> owner = _reverse_lookup.find(phone_number, _arena.phone_numbers());
+        if (owner == id) {
+            _reverse_lookup.erase(phone_number, _arena.phone_numbers());
+            _sorted_phone_numbers.erase(phone_number, _arena.phone_numbers());
+        }
     }
 
+    /// Запись, на которую больше не ссылается ни один индекс; живые записи - ровно те, что в _lookup
+    void release(uint32_t id) {
+        _arena.release(id);
+        if (static_cast<double>(_arena.released_bytes()) <= compaction_ratio * static_cast<double>(_arena.bytes())) {
+            return;
+        }
 
-    /// mapping name->phone number and reversed
-    std::map<std::string, std::string> _lookup, _reverse_lookup;
+        std::vector<uint32_t> ids = live_ids();
+        std::sort(ids.begin(), ids.end());
+        std::vector<uint32_t> new_ids = _arena.compact(ids);
+        _lookup.remap(new_ids);
+        _reverse_lookup.remap(new_ids);
+        _sorted_names.remap(new_ids);
+        _sorted_phone_numbers.remap(new_ids);
+    }
+
+
+    /// mapping name->record and phone number->record, и те же записи в порядке ключей для поиска по префиксу
+    RecordArena _arena;
+    FlatIdIndex _lookup, _reverse_lookup;
+    SortedIdIndex _sorted_names, _sorted_phone_numbers;
 };
 
 PhoneBook get_test_data() {
@@ -183,7 +700,7 @@ void test_search_by_name() {
     assert(s1.value() == "466-768-4109x5156");
 
     s1 = book.search_by_name("iurync394m8mry3984");
-    assert(s1->empty());
+    assert(!s1.has_value());
 }
 
 void test_search_by_phone_number() {
@@ -202,7 +719,7 @@ void test_search_by_phone_number() {
     assert(s1.value() == "Amanda");
 
     s1 = book.search_by_phone_number("iurync394m8mry3984");
-    assert(s1->empty());
+    assert(!s1.has_value());
 }
 
 void test_add() {
@@ -251,10 +768,153 @@ void test_remove() {
 
 }
 
+void test_prefix_search() {
+    PhoneBook book = get_test_data();
+
+    auto page = book.search_by_name_prefix("Mich", 2);
+    assert(page.entries.size() == 2 && page.cursor == "Michele");
+    assert(page.entries[0] == std::make_pair(std::string_view("Michael"), std::string_view("+1-297-398-2447x4608")));
+    assert(page.entries[1].first == "Michele");
+    page = book.search_by_name_prefix("Mich", 2, page.cursor);
+    assert(page.entries.size() == 1 && page.entries[0].first == "Michelle" && !page.cursor);
+
+    page = book.search_by_phone_number_prefix("+1-7", 10);
+    assert(page.entries.size() == 3 && !page.cursor);
+    assert(page.entries[0].first == "Steven" && page.entries[1].first == "Jessica" && page.entries[2].first == "Emily");
+    assert(page.entries[2].second == "+1-738-667-7116x42413");
+
+    assert(book.search_by_name_prefix("Zed", 10).entries.empty());
+    assert(book.search_by_name_prefix("", 1000).entries.size() == book.size());
+
+    // курсор - ключ, а не позиция: изменения между страницами не сбивают выдачу
+    page = book.search_by_name_prefix("J", 2);
+    assert(page.entries[1].first == "James");
+    book.add("Jaap", "1");
+    book.remove("Jasmine");
+    page = book.search_by_name_prefix("J", 2, page.cursor);
+    assert(page.entries[0].first == "Jason" && page.entries[1].first == "Jeffrey");
+    assert(book.search_by_phone_number_prefix("1", 5).entries[0].first == "Jaap");
+}
+
+void test_flat_map() {
+    std::vector<std::string> keys;
+    auto key_of = [&](uint32_t id) { return std::string_view(keys[id]); };
+    FlatIdIndex index;
+    assert(!index.find("a", key_of) && !index.erase("a", key_of));
+
+    // удалённые слоты переиспользуются: таблица не растёт от череды вставок и удалений
+    for (uint32_t i = 0; i < 100000; ++i) {
+        keys.push_back(std::to_string(i));
+        assert(index.insert_or_assign(keys[i], i, key_of));
+        if (i >= 10) assert(index.erase(std::to_string(i - 10), key_of));
+    }
+    assert(index.size() == 10 && index.capacity() <= 64);
+    assert(index.find("99995", key_of) == 99995u && !index.find("5", key_of));
+    keys.emplace_back("99995");
+    assert(!index.insert_or_assign("99995", 100000, key_of) && index.find("99995", key_of) == 100000u);
+
+    // перенумерация не двигает слоты
+    std::vector<uint32_t> new_ids(keys.size());
+    std::vector<std::string> compacted;
+    index.for_each([&](uint32_t id) {
+        new_ids[id] = static_cast<uint32_t>(compacted.size());
+        compacted.push_back(keys[id]);
+    });
+    keys = compacted;
+    index.remap(new_ids);
+    assert(index.size() == 10 && key_of(*index.find("99999", key_of)) == "99999");
+}
+
+void test_arena() {
+    RecordArena arena;
+    uint32_t a = arena.append("Ann", "123"), b = arena.append("Bob", "45"), c = arena.append("", "6");
+    assert(arena.name(b) == "Bob" && arena.phone_number(b) == "45" && arena.name(c).empty());
+    assert(arena.bytes() == 12);
+
+    arena.release(b);
+    assert(arena.released_bytes() == 5 && arena.name(b) == "Bob"); // до сжатия байты ещё читаются
+    std::vector<uint32_t> new_ids = arena.compact({a, c});
+    assert(new_ids[a] == 0 && new_ids[c] == 1);
+    assert(arena.bytes() == 7 && arena.released_bytes() == 0);
+    assert(arena.name(0) == "Ann" && arena.phone_number(0) == "123" && arena.phone_number(1) == "6");
+}
+
+void test_large_book() {
+    // против std::map с теми же правилами: номер принадлежит последнему, кто его записал
+    PhoneBook book;
+    std::map<std::string, std::string> names, numbers;
+    std::mt19937 generator(9);
+    auto random_key = [&](const char *prefix, size_t range) {
+        return prefix + std::to_string(generator() % range);
+    };
+    auto release = [&](const std::string &name) {
+        auto owner = numbers.find(names[name]);
+        if (owner != numbers.end() && owner->second == name) numbers.erase(owner);
+    };
+
+    std::streambuf *output = std::cout.rdbuf(nullptr); // предупреждения о перезаписи не нужны
+    for (int step = 0; step < 200000; ++step) {
+        std::string name = random_key("name", 50000), phone_number = random_key("+7-", 60000);
+        if (generator() % 4 == 0) {
+            bool removed = names.contains(name);
+            if (removed) {
+                release(name);
+                names.erase(name);
+            }
+            assert(book.remove(name) == removed);
+        } else {
+            bool existed = names.contains(name);
+            if (existed) release(name);
+            names[name] = phone_number;
+            numbers[phone_number] = name;
+            assert(book.add(name, phone_number) == existed);
+        }
+    }
+    std::cout.rdbuf(output);
+
+    // сжатие держит хранилище не больше чем вдвое больше живых данных
+    size_t live_bytes = 0;
+    for (const auto &[name, phone_number]: names) live_bytes += name.size() + phone_number.size();
+    assert(book.size() == names.size() && book.storage_bytes() <= 2 * live_bytes);
+    for (const auto &[name, phone_number]: names) assert(book.search_by_name(name) == phone_number);
+    for (const auto &[phone_number, name]: numbers) assert(book.search_by_phone_number(phone_number) == name);
+    for (int i = 0; i < 1000; ++i) {
+        std::string phone_number = random_key("+7-", 60000);
+        assert(book.search_by_phone_number(phone_number).has_value() == numbers.contains(phone_number));
+    }
+
+    // постраничный поиск по префиксу совпадает с диапазоном упорядоченного словаря
+    for (const char *prefix: {"name1", "name42", "+7-5", "+7-59999", "x"}) {
+        bool by_name = prefix[0] != '+';
+        const auto &model = by_name ? names : numbers;
+        std::vector<std::string> expected, found;
+        for (auto it = model.lower_bound(prefix); it != model.end() && it->first.starts_with(prefix); ++it) {
+            expected.push_back(it->first);
+        }
+
+        std::optional<std::string> cursor;
+        do {
+            PrefixPage page = by_name ? book.search_by_name_prefix(prefix, 1000, cursor)
+                                      : book.search_by_phone_number_prefix(prefix, 1000, cursor);
+            for (const auto &[name, phone_number]: page.entries) found.emplace_back(by_name ? name : phone_number);
+            cursor = page.cursor;
+        } while (cursor);
+        assert(found == expected);
+    }
+
+    // результат поиска можно сразу передать обратно в книгу
+    auto owner = book.search_by_phone_number(numbers.begin()->first);
+    assert(book.remove(owner.value()));
+}
+
 int main() {
     test_print();
     test_search_by_name();
     test_search_by_phone_number();
     test_add();
     test_remove();
+    test_prefix_search();
+    test_flat_map();
+    test_arena();
+    test_large_book();
 }
\ No newline at end of file